@@ -786,28 +786,11 @@ void PeerListContent::addToSearchIndex(not_null<PeerListRow*> row) {
 		return;
 	}
 
-	removeFromSearchIndex(row);
-	row->setNameFirstLetters(row->peer()->nameFirstLetters());
-	for (auto ch : row->nameFirstLetters()) {
-		_searchIndex[ch].push_back(row);
-	}
+	_searchIndex.add(row, row->peer()->nameWords());
 }
 
 void PeerListContent::removeFromSearchIndex(not_null<PeerListRow*> row) {
-	const auto &nameFirstLetters = row->nameFirstLetters();
-	if (!nameFirstLetters.empty()) {
-		for (auto ch : row->nameFirstLetters()) {
-			auto it = _searchIndex.find(ch);
-			if (it != _searchIndex.cend()) {
-				auto &entry = it->second;
-				entry.erase(ranges::remove(entry, row), end(entry));
-				if (entry.empty()) {
-					_searchIndex.erase(it);
-				}
-			}
-		}
-		row->setNameFirstLetters({});
-	}
+	_searchIndex.remove(row);
 }
 
 void PeerListContent::prependRow(std::unique_ptr<PeerListRow> row) {
@@ -1442,46 +1425,12 @@ void PeerListContent::searchQueryChanged(QString query) {
 	if (_normalizedSearchQuery != normalizedQuery) {
 		setSearchQuery(query, normalizedQuery);
 		if (_controller->searchInLocal() && !searchWordsList.isEmpty()) {
-			auto minimalList = (const std::vector<not_null<PeerListRow*>>*)nullptr;
-			for (const auto &searchWord : searchWordsList) {
-				auto searchWordStart = searchWord[0].toLower();
-				auto it = _searchIndex.find(searchWordStart);
-				if (it == _searchIndex.cend()) {
-					// Some word can't be found in any row.
-					minimalList = nullptr;
-					break;
-				} else if (!minimalList || minimalList->size() > it->second.size()) {
-					minimalList = &it->second;
-				}
-			}
-			if (minimalList) {
-				auto searchWordInNames = [](
-						not_null<PeerData*> peer,
-						const QString &searchWord) {
-					for (auto &nameWord : peer->nameWords()) {
-						if (nameWord.startsWith(searchWord)) {
-							return true;
-						}
-					}
-					return false;
-				};
-				auto allSearchWordsInNames = [&](
-						not_null<PeerData*> peer) {
-					for (const auto &searchWord : searchWordsList) {
-						if (!searchWordInNames(peer, searchWord)) {
-							return false;
-						}
-					}
-					return true;
-				};
-
-				_filterResults.reserve(minimalList->size());
-				for (const auto row : *minimalList) {
-					if (!row->special() && allSearchWordsInNames(row->peer())) {
-						_filterResults.push_back(row);
-					}
-				}
-			}
+			_filterResults = _searchIndex.find(searchWordsList);
+			ranges::sort(_filterResults, [](
+					not_null<PeerListRow*> a,
+					not_null<PeerListRow*> b) {
+				return a->absoluteIndex() < b->absoluteIndex();
+			});
 		}
 		if (_controller->hasComplexSearch()) {
 			_controller->search(_searchQuery);
@@ -12,6 +12,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "boxes/abstract_box.h"
 #include "mtproto/sender.h"
 #include "data/data_cloud_file.h"
+#include "dialogs/dialogs_search_index.h"
 #include "base/timer.h"
 
 namespace style {
@@ -182,13 +183,6 @@ public:
 		int outerWidth);
 	float64 checkedRatio();
 
-	void setNameFirstLetters(const base::flat_set<QChar> &firstLetters) {
-		_nameFirstLetters = firstLetters;
-	}
-	const base::flat_set<QChar> &nameFirstLetters() const {
-		return _nameFirstLetters;
-	}
-
 	virtual void lazyInitialize(const style::PeerListItem &st);
 	virtual void paintStatusText(
 		Painter &p,
@@ -228,7 +222,6 @@ private:
 	Ui::Text::String _status;
 	StatusType _statusType = StatusType::Online;
 	crl::time _statusValidTill = 0;
-	base::flat_set<QChar> _nameFirstLetters;
 	int _absoluteIndex = -1;
 	State _disabledState = State::Active;
 	bool _initialized : 1;
@@ -515,9 +508,6 @@ public:
 	template <typename ReorderCallback>
 	void reorderRows(ReorderCallback &&callback) {
 		callback(_rows.begin(), _rows.end());
-		for (auto &searchEntity : _searchIndex) {
-			callback(searchEntity.second.begin(), searchEntity.second.end());
-		}
 		refreshIndices();
 		update();
 	}
@@ -655,7 +645,7 @@ private:
 	std::map<PeerListRowId, not_null<PeerListRow*>> _rowsById;
 	std::map<PeerData*, std::vector<not_null<PeerListRow*>>> _rowsByPeer;
 
-	std::map<QChar, std::vector<not_null<PeerListRow*>>> _searchIndex;
+	Dialogs::SearchIndex<not_null<PeerListRow*>> _searchIndex;
 	QString _searchQuery;
 	QString _normalizedSearchQuery;
 	QString _mentionHighlight;
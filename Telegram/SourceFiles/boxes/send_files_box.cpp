@@ -26,6 +26,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/mime_type.h"
 #include "base/event_filter.h"
 #include "ui/effects/animations.h"
+#include "ui/effects/frame_scheduler.h"
 #include "ui/widgets/checkbox.h"
 #include "ui/widgets/buttons.h"
 #include "ui/widgets/input_fields.h"
@@ -191,6 +192,7 @@ private:
 	int _previewHeight = 0;
 	Media::Clip::ReaderPointer _gifPreview;
 	std::unique_ptr<Lottie::SinglePlayer> _lottiePreview;
+	Fn<void()> _repaintFrame;
 
 };
 
@@ -875,6 +877,10 @@ void SingleMediaPreview::preparePreview(
 
 void SingleMediaPreview::prepareAnimatedPreview(
 		const QString &animatedPreviewPath) {
+	_repaintFrame = Core::App().frameScheduler().wrap(
+		Ui::FramePriority::Panel,
+		[=] { update(); },
+		lifetime());
 	if (_sticker && _animated) {
 		const auto box = QSize(_previewWidth, _previewHeight)
 			* cIntRetinaFactor();
@@ -883,7 +889,7 @@ void SingleMediaPreview::prepareAnimatedPreview(
 			Lottie::FrameRequest{ box });
 		_lottiePreview->updates(
 		) | rpl::start_with_next([=] {
-			update();
+			_repaintFrame();
 		}, lifetime());
 	} else if (!animatedPreviewPath.isEmpty()) {
 		auto callback = [=](Media::Clip::Notification notification) {
@@ -913,7 +919,7 @@ void SingleMediaPreview::clipCallback(Media::Clip::Notification notification) {
 
 	case NotificationRepaint: {
 		if (_gifPreview && !_gifPreview->currentDisplayed()) {
-			update();
+			_repaintFrame();
 		}
 	} break;
 	}
@@ -22,6 +22,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/widgets/scroll_area.h"
 #include "ui/image/image.h"
 #include "ui/image/image_location_factory.h"
+#include "ui/effects/frame_scheduler.h"
 #include "ui/text/text_utilities.h"
 #include "ui/emoji_config.h"
 #include "ui/toast/toast.h"
@@ -543,9 +544,13 @@ not_null<Lottie::MultiPlayer*> StickerSetBox::Inner::getLottiePlayer() {
 		_lottiePlayer = std::make_unique<Lottie::MultiPlayer>(
 			Lottie::Quality::Default,
 			Lottie::MakeFrameRenderer());
+		const auto repaint = Core::App().frameScheduler().wrap(
+			Ui::FramePriority::Panel,
+			[=] { update(); },
+			lifetime());
 		_lottiePlayer->updates(
 		) | rpl::start_with_next([=] {
-			update();
+			repaint();
 		}, lifetime());
 	}
 	return _lottiePlayer.get();
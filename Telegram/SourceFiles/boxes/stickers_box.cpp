@@ -28,6 +28,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/widgets/labels.h"
 #include "ui/widgets/scroll_area.h"
 #include "ui/widgets/shadow.h"
+#include "ui/effects/frame_scheduler.h"
 #include "ui/effects/ripple_animation.h"
 #include "ui/effects/slide_animation.h"
 #include "ui/widgets/discrete_sliders.h"
@@ -170,6 +171,7 @@ private:
 		anim::value yadd;
 		std::unique_ptr<Ui::RippleAnimation> ripple;
 		std::unique_ptr<Lottie::SinglePlayer> lottie;
+		rpl::lifetime lottieLifetime;
 	};
 	struct MegagroupSet {
 		inline bool operator==(const MegagroupSet &other) const {
@@ -1257,10 +1259,14 @@ void StickersBox::Inner::validateLottieAnimation(not_null<Row*> row) {
 		return;
 	}
 	row->lottie = std::move(player);
+	const auto repaint = Core::App().frameScheduler().wrap(
+		Ui::FramePriority::Background,
+		[=] { updateRowThumbnail(row); },
+		row->lottieLifetime);
 	row->lottie->updates(
 	) | rpl::start_with_next([=] {
-		updateRowThumbnail(row);
-	}, lifetime());
+		repaint();
+	}, row->lottieLifetime);
 }
 
 void StickersBox::Inner::updateRowThumbnail(not_null<Row*> row) {
@@ -1929,6 +1935,7 @@ void StickersBox::Inner::updateRows() {
 			fillSetCover(set, &sticker, &pixw, &pixh);
 			if (sticker) {
 				if (row->sticker != sticker && !row->thumbnailMedia) {
+					row->lottieLifetime.destroy();
 					row->lottie = nullptr;
 					row->stickerMedia = nullptr;
 				}
@@ -23,6 +23,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "main/main_session.h"
 #include "storage/storage_account.h"
 #include "core/application.h"
+#include "ui/effects/frame_scheduler.h"
 #include "core/core_settings.h"
 #include "lottie/lottie_single_player.h"
 #include "ui/widgets/popup_menu.h"
@@ -1104,14 +1105,18 @@ void FieldAutocompleteInner::setupLottie(StickerSuggestion &suggestion) {
 	const auto document = suggestion.document;
 	suggestion.animated = ChatHelpers::LottiePlayerFromDocument(
 		suggestion.documentMedia.get(),
-		ChatHelpers::StickerLottieSize::InlineResults,
+		ChatHelpers::StickerLottieSize::StickerSet,
 		stickerBoundingBox() * cIntRetinaFactor(),
 		Lottie::Quality::Default,
 		getLottieRenderer());
 
+	const auto repaint = Core::App().frameScheduler().wrap(
+		Ui::FramePriority::Panel,
+		[=] { repaintSticker(document); },
+		_stickersLifetime);
 	suggestion.animated->updates(
 	) | rpl::start_with_next([=] {
-		repaintSticker(document);
+		repaint();
 	}, _stickersLifetime);
 }
 
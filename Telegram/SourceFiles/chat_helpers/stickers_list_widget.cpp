@@ -16,9 +16,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_changes.h"
 #include "chat_helpers/send_context_menu.h" // SendMenu::FillSendMenu
 #include "chat_helpers/stickers_lottie.h"
+#include "core/application.h"
 #include "ui/widgets/buttons.h"
 #include "ui/widgets/popup_menu.h"
 #include "ui/effects/animations.h"
+#include "ui/effects/frame_scheduler.h"
 #include "ui/effects/ripple_animation.h"
 #include "ui/image/image.h"
 #include "lottie/lottie_multi_player.h"
@@ -762,9 +764,13 @@ void StickersListWidget::Footer::validateIconLottieAnimation(
 	icon.lottie = std::move(player);
 
 	const auto id = icon.setId;
+	const auto repaint = Core::App().frameScheduler().wrap(
+		Ui::FramePriority::Background,
+		[=] { updateSetIcon(id); },
+		icon.lifetime);
 	icon.lottie->updates(
 	) | rpl::start_with_next([=] {
-		updateSetIcon(id);
+		repaint();
 	}, icon.lifetime);
 }
 
@@ -1788,20 +1794,25 @@ void StickersListWidget::ensureLottiePlayer(Set &set) {
 		getLottieRenderer());
 	const auto raw = set.lottiePlayer.get();
 
+	const auto repaint = Core::App().frameScheduler().wrap(
+		Ui::FramePriority::Panel,
+		[=] {
+			enumerateSections([&](const SectionInfo &info) {
+				if (shownSets()[info.section].lottiePlayer.get() == raw) {
+					update(
+						0,
+						info.rowsTop,
+						width(),
+						info.rowsBottom - info.rowsTop);
+					return false;
+				}
+				return true;
+			});
+		},
+		set.lottieLifetime);
 	raw->updates(
 	) | rpl::start_with_next([=] {
-		const auto &sets = shownSets();
-		enumerateSections([&](const SectionInfo &info) {
-			if (shownSets()[info.section].lottiePlayer.get() == raw) {
-				update(
-					0,
-					info.rowsTop,
-					width(),
-					info.rowsBottom - info.rowsTop);
-				return false;
-			}
-			return true;
-		});
+		repaint();
 	}, set.lottieLifetime);
 }
 
@@ -1815,14 +1826,16 @@ void StickersListWidget::setupLottie(Set &set, int section, int index) {
 	sticker.animated = LottieAnimationFromDocument(
 		set.lottiePlayer.get(),
 		sticker.documentMedia.get(),
-		StickerLottieSize::StickersPanel,
+		StickerLottieSize::StickerSet,
 		boundingBoxSize() * cIntRetinaFactor());
 }
 
 QSize StickersListWidget::boundingBoxSize() const {
+	// Not _singleSize, so that the animated stickers are rendered in the
+	// same box as in the set box and share the cached frames with it.
 	return QSize(
-		_singleSize.width() - st::buttonRadius * 2,
-		_singleSize.height() - st::buttonRadius * 2);
+		st::stickerPanSize.width() - st::buttonRadius * 2,
+		st::stickerPanSize.height() - st::buttonRadius * 2);
 }
 
 void StickersListWidget::paintSticker(Painter &p, Set &set, int y, int section, int index, bool selected, bool deleteSelected) {
@@ -2394,6 +2407,7 @@ void StickersListWidget::refreshSearchSets() {
 			const auto set = it->second.get();
 			entry.flags = set->flags;
 			if (!set->stickers.empty()) {
+				entry.lottieLifetime.destroy();
 				entry.lottiePlayer = nullptr;
 				entry.stickers = PrepareStickers(set->stickers);
 			}
@@ -33,13 +33,14 @@ class StickersSetThumbnailView;
 
 namespace ChatHelpers {
 
+// Cached frames are keyed by this tag, so it must be different for the
+// boxes of different size. The places that always render stickers in the
+// same box use the same tag and read the same cached frames.
 enum class StickerLottieSize : uchar {
 	MessageHistory,
-	StickerSet,
-	StickersPanel,
+	StickerSet, // Also the panel, inline results and suggestions.
 	StickersFooter,
 	SetsListThumbnail,
-	InlineResults,
 };
 
 [[nodiscard]] std::unique_ptr<Lottie::SinglePlayer> LottiePlayerFromDocument(
@@ -59,6 +59,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/text_options.h"
 #include "ui/emoji_config.h"
 #include "ui/effects/animations.h"
+#include "ui/effects/frame_scheduler.h"
 #include "storage/serialize_common.h"
 #include "storage/storage_domain.h"
 #include "storage/storage_databases.h"
@@ -102,6 +103,7 @@ Application::Application(not_null<Launcher*> launcher)
 , _private(std::make_unique<Private>())
 , _databases(std::make_unique<Storage::Databases>())
 , _animationsManager(std::make_unique<Ui::Animations::Manager>())
+, _frameScheduler(std::make_unique<Ui::FrameScheduler>())
 , _clearEmojiImageLoaderTimer([=] { clearEmojiSourceImages(); })
 , _audio(std::make_unique<Media::Audio::Instance>())
 , _fallbackProductionConfig(
@@ -272,6 +274,10 @@ void Application::run() {
 
 	_window->updateIsActiveFocus();
 
+	if (!cExportRunPath().isEmpty()) {
+		startExportRunner();
+	}
+
 	for (const auto &error : Shortcuts::Errors()) {
 		LOG(("Shortcuts Error: %1").arg(error));
 	}
@@ -291,6 +297,18 @@ void Application::startDomain() {
 	}
 }
 
+void Application::startExportRunner() {
+	// Wait for the authorized session, it may need the passcode first.
+	activeAccount().sessionValue(
+	) | rpl::filter([](Main::Session *session) {
+		return (session != nullptr);
+	}) | rpl::take(
+		1
+	) | rpl::start_with_next([=](Main::Session *session) {
+		_exportManager->startHeadless(session, cExportRunPath());
+	}, _lifetime);
+}
+
 void Application::startSettingsAndBackground() {
 	Local::rewriteSettingsIfNeeded();
 	Window::Theme::Background()->start();
@@ -47,6 +47,7 @@ class Session;
 } // namespace Main
 
 namespace Ui {
+class FrameScheduler;
 namespace Animations {
 class Manager;
 } // namespace Animations
@@ -125,6 +126,9 @@ public:
 	[[nodiscard]] Ui::Animations::Manager &animationManager() const {
 		return *_animationsManager;
 	}
+	[[nodiscard]] Ui::FrameScheduler &frameScheduler() const {
+		return *_frameScheduler;
+	}
 	[[nodiscard]] Window::Notifications::System &notifications() const {
 		Expects(_notifications != nullptr);
 
@@ -293,6 +297,7 @@ private:
 	void startLocalStorage();
 	void startShortcuts();
 	void startDomain();
+	void startExportRunner();
 	void startEmojiImageLoader();
 	void startSystemDarkModeViewer();
 
@@ -331,6 +336,7 @@ private:
 
 	const std::unique_ptr<Storage::Databases> _databases;
 	const std::unique_ptr<Ui::Animations::Manager> _animationsManager;
+	const std::unique_ptr<Ui::FrameScheduler> _frameScheduler;
 	crl::object_on_queue<Stickers::EmojiImageLoader> _emojiImageLoader;
 	base::Timer _clearEmojiImageLoaderTimer;
 	const std::unique_ptr<Media::Audio::Instance> _audio;
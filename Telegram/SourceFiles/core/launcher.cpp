@@ -457,6 +457,9 @@ void Launcher::processArguments() {
 		{ "-workdir"        , KeyFormat::OneValue },
 		{ "--"              , KeyFormat::OneValue },
 		{ "-scale"          , KeyFormat::OneValue },
+		{ "-mtprecord"      , KeyFormat::OneValue },
+		{ "-mtpreplay"      , KeyFormat::OneValue },
+		{ "-exportrun"      , KeyFormat::OneValue },
 	};
 	auto parseResult = QMap<QByteArray, QStringList>();
 	auto parsingKey = QByteArray();
@@ -506,6 +509,12 @@ void Launcher::processArguments() {
 		}
 	}
 	gStartUrl = parseResult.value("--", {}).join(QString());
+	gMtpRecordPath = parseResult.value("-mtprecord", {}).join(QString());
+	gMtpReplayPath = parseResult.value("-mtpreplay", {}).join(QString());
+	if (!gMtpReplayPath.isEmpty()) {
+		gMtpRecordPath = QString();
+	}
+	gExportRunPath = parseResult.value("-exportrun", {}).join(QString());
 
 	const auto scaleKey = parseResult.value("-scale", {});
 	if (scaleKey.size() > 0) {
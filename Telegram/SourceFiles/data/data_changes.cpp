@@ -23,7 +23,7 @@ void Changes::Manager<DataType, UpdateType>::updated(
 			flags |= i->second;
 			_updates.erase(i);
 		}
-		_stream.fire({ data, flags });
+		fire({ data, flags });
 	} else {
 		_updates[data] |= flags;
 	}
@@ -54,11 +54,68 @@ template <typename DataType, typename UpdateType>
 rpl::producer<UpdateType> Changes::Manager<DataType, UpdateType>::updates(
 		not_null<DataType*> data,
 		Flags flags) const {
-	return _stream.events(
-	) | rpl::filter([=](const UpdateType &update) {
-		const auto [updateData, updateFlags] = update;
-		return (updateData == data) && (updateFlags & flags);
-	});
+	const auto weak = std::weak_ptr<KeyedStreams>(_keyed);
+	return [=](auto consumer) {
+		auto result = rpl::lifetime();
+		const auto keyed = weak.lock();
+		if (!keyed) {
+			return result;
+		}
+		keyed->subscribe(data, flags);
+		result.add([=] {
+			if (const auto keyed = weak.lock()) {
+				keyed->unsubscribe(data, flags);
+			}
+		});
+
+		// Lifetime is destroyed in reverse order, so we unsubscribe
+		// from the stream before the entry with it may be removed.
+		const auto entry = keyed->map[data].get();
+		entry->stream.events(
+		) | rpl::filter([=](const UpdateType &update) {
+			return (update.flags & flags);
+		}) | rpl::start_with_next([=](const UpdateType &update) {
+			++entry->delivered;
+			consumer.put_next_copy(update);
+		}, result);
+		return result;
+	};
+}
+
+template <typename DataType, typename UpdateType>
+void Changes::Manager<DataType, UpdateType>::KeyedStreams::subscribe(
+		not_null<DataType*> data,
+		Flags flags) {
+	auto &entry = map[data];
+	if (!entry) {
+		entry = std::make_shared<Keyed>();
+	}
+	++entry->subscribers;
+	for (auto i = 0; i != kCount; ++i) {
+		if (flags & static_cast<Flag>(1U << i)) {
+			++entry->counts[i];
+		}
+	}
+	entry->flags |= flags;
+}
+
+template <typename DataType, typename UpdateType>
+void Changes::Manager<DataType, UpdateType>::KeyedStreams::unsubscribe(
+		not_null<DataType*> data,
+		Flags flags) {
+	const auto i = map.find(data);
+	Assert(i != end(map));
+
+	const auto &entry = i->second;
+	for (auto j = 0; j != kCount; ++j) {
+		const auto flag = static_cast<Flag>(1U << j);
+		if ((flags & flag) && !--entry->counts[j]) {
+			entry->flags &= ~flag;
+		}
+	}
+	if (!--entry->subscribers) {
+		map.erase(i);
+	}
 }
 
 template <typename DataType, typename UpdateType>
@@ -79,10 +136,35 @@ rpl::producer<UpdateType> Changes::Manager<DataType, UpdateType>::flagsValue(
 template <typename DataType, typename UpdateType>
 void Changes::Manager<DataType, UpdateType>::sendNotifications() {
 	for (const auto [data, flags] : base::take(_updates)) {
-		_stream.fire({ data, flags });
+		fire({ data, flags });
 	}
 }
 
+template <typename DataType, typename UpdateType>
+void Changes::Manager<DataType, UpdateType>::fire(UpdateType update) {
+	const auto [data, flags] = update;
+	++_fanOut.notifications;
+	_stream.fire_copy(update);
+
+	const auto i = _keyed->map.find(data);
+	if (i == end(_keyed->map) || !(i->second->flags & flags)) {
+		return;
+	}
+	// Hold the entry, subscribers may unsubscribe while we fire.
+	const auto keyed = i->second;
+	const auto was = base::take(keyed->delivered);
+	keyed->stream.fire(std::move(update));
+	const auto delivered = std::exchange(keyed->delivered, was);
+	_fanOut.keyedDeliveries += delivered;
+	accumulate_max(_fanOut.maxKeyedDeliveries, delivered);
+}
+
+template <typename DataType, typename UpdateType>
+auto Changes::Manager<DataType, UpdateType>::fanOut() const
+-> const ChangesFanOut & {
+	return _fanOut;
+}
+
 Changes::Changes(not_null<Main::Session*> session) : _session(session) {
 }
 
@@ -233,6 +315,20 @@ void Changes::scheduleNotifications() {
 	}
 }
 
+ChangesFanOut Changes::fanOut() const {
+	auto result = ChangesFanOut();
+	const auto add = [&](const ChangesFanOut &value) {
+		result.notifications += value.notifications;
+		result.keyedDeliveries += value.keyedDeliveries;
+		accumulate_max(result.maxKeyedDeliveries, value.maxKeyedDeliveries);
+	};
+	add(_peerChanges.fanOut());
+	add(_historyChanges.fanOut());
+	add(_messageChanges.fanOut());
+	add(_entryChanges.fanOut());
+	return result;
+}
+
 void Changes::sendNotifications() {
 	if (!_notify) {
 		return;
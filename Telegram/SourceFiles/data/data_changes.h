@@ -165,6 +165,12 @@ struct EntryUpdate {
 
 };
 
+struct ChangesFanOut {
+	uint64 notifications = 0;
+	uint64 keyedDeliveries = 0;
+	int maxKeyedDeliveries = 0;
+};
+
 class Changes final {
 public:
 	explicit Changes(not_null<Main::Session*> session);
@@ -234,6 +240,8 @@ public:
 
 	void sendNotifications();
 
+	[[nodiscard]] ChangesFanOut fanOut() const;
+
 private:
 	template <typename DataType, typename UpdateType>
 	class Manager final {
@@ -257,14 +265,37 @@ private:
 
 		void sendNotifications();
 
+		[[nodiscard]] const ChangesFanOut &fanOut() const;
+
 	private:
 		static constexpr auto kCount = details::CountBit<Flag>();
 
+		// Subscribers to one data, with subscriber counts by flag bit.
+		struct Keyed {
+			rpl::event_stream<UpdateType> stream;
+			std::array<int, kCount> counts = { { 0 } };
+			Flags flags;
+			int subscribers = 0;
+			int delivered = 0;
+		};
+		struct KeyedStreams {
+			void subscribe(not_null<DataType*> data, Flags flags);
+			void unsubscribe(not_null<DataType*> data, Flags flags);
+
+			std::unordered_map<
+				not_null<DataType*>,
+				std::shared_ptr<Keyed>> map;
+		};
+
 		void sendRealtimeNotifications(not_null<DataType*> data, Flags flags);
+		void fire(UpdateType update);
 
 		std::array<rpl::event_stream<UpdateType>, kCount> _realtimeStreams;
 		base::flat_map<not_null<DataType*>, Flags> _updates;
 		rpl::event_stream<UpdateType> _stream;
+		const std::shared_ptr<KeyedStreams> _keyed
+			= std::make_shared<KeyedStreams>();
+		ChangesFanOut _fanOut;
 
 	};
 
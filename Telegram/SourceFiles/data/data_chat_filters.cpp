@@ -15,6 +15,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_session.h"
 #include "data/data_folder.h"
 #include "data/data_histories.h"
+#include "data/data_changes.h"
 #include "dialogs/dialogs_main_list.h"
 #include "ui/ui_utility.h"
 #include "main/main_session.h"
@@ -26,6 +27,9 @@ namespace {
 constexpr auto kRefreshSuggestedTimeout = 7200 * crl::time(1000);
 constexpr auto kLoadExceptionsAfter = 100;
 constexpr auto kLoadExceptionsPerRequest = 100;
+constexpr auto kRuleFlags = ChatFilter::Flag::NoMuted
+	| ChatFilter::Flag::NoRead
+	| ChatFilter::Flag::NoArchived;
 
 } // namespace
 
@@ -174,9 +178,9 @@ const base::flat_set<not_null<History*>> &ChatFilter::never() const {
 	return _never;
 }
 
-bool ChatFilter::contains(not_null<History*> history) const {
-	const auto flag = [&] {
-		const auto peer = history->peer;
+ChatFilter::Flags ChatFilter::HistoryFlags(not_null<History*> history) {
+	const auto peer = history->peer;
+	const auto type = [&] {
 		if (const auto user = peer->asUser()) {
 			return user->isBot()
 				? Flag::Bots
@@ -192,31 +196,55 @@ bool ChatFilter::contains(not_null<History*> history) const {
 				return Flag::Groups;
 			}
 		} else {
-			Unexpected("Peer type in ChatFilter::contains.");
+			Unexpected("Peer type in ChatFilter::HistoryFlags.");
 		}
 	}();
+	const auto notArchived = history->folderKnown() && !history->folder();
+	const auto notMuted = !history->mute()
+		|| (history->hasUnreadMentions() && notArchived);
+	const auto notRead = history->unreadCount()
+		|| history->unreadMark()
+		|| history->hasUnreadMentions()
+		|| history->fakeUnreadWhileOpened();
+	auto result = Flags(type);
+	if (notMuted) {
+		result |= Flag::NoMuted;
+	}
+	if (notRead) {
+		result |= Flag::NoRead;
+	}
+	if (notArchived) {
+		result |= Flag::NoArchived;
+	}
+	return result;
+}
+
+bool ChatFilter::contains(not_null<History*> history) const {
+	return contains(history, HistoryFlags(history));
+}
+
+bool ChatFilter::contains(
+		not_null<History*> history,
+		Flags historyFlags) const {
 	if (_never.contains(history)) {
 		return false;
 	}
-	return false
-		|| ((_flags & flag)
-			&& (!(_flags & Flag::NoMuted)
-				|| !history->mute()
-				|| (history->hasUnreadMentions()
-					&& history->folderKnown()
-					&& !history->folder()))
-			&& (!(_flags & Flag::NoRead)
-				|| history->unreadCount()
-				|| history->unreadMark()
-				|| history->hasUnreadMentions()
-				|| history->fakeUnreadWhileOpened())
-			&& (!(_flags & Flag::NoArchived)
-				|| (history->folderKnown() && !history->folder())))
+	const auto rules = _flags & kRuleFlags;
+	return ((_flags & historyFlags & ~kRuleFlags)
+			&& ((historyFlags & rules) == rules))
 		|| _always.contains(history);
 }
 
 ChatFilters::ChatFilters(not_null<Session*> owner) : _owner(owner) {
 	crl::on_main(&owner->session(), [=] { load(); });
+
+	owner->session().changes().peerUpdates(
+		PeerUpdate::Flag::IsContact
+	) | rpl::start_with_next([=](const PeerUpdate &update) {
+		if (const auto history = _owner->historyLoaded(update.peer)) {
+			refreshHistory(history);
+		}
+	}, _lifetime);
 }
 
 ChatFilters::~ChatFilters() = default;
@@ -369,8 +397,16 @@ bool ChatFilters::applyChange(ChatFilter &filter, ChatFilter &&updated) {
 	if (rulesChanged) {
 		const auto filterList = _owner->chatsFilters().chatsList(id);
 		const auto feedHistory = [&](not_null<History*> history) {
-			const auto now = updated.contains(history);
-			const auto was = filter.contains(history);
+			// Only this filter is refreshed with these flags, so they
+			// can't be cached. If they're different from the cached ones
+			// the other filters should still be refreshed later.
+			const auto flags = ChatFilter::HistoryFlags(history);
+			const auto i = _historyFlags.find(history);
+			if (i != end(_historyFlags) && i->second != flags) {
+				_historyFlags.erase(i);
+			}
+			const auto now = updated.contains(history, flags);
+			const auto was = filter.contains(history, flags);
 			if (now != was) {
 				if (now) {
 					history->addToChatList(id, filterList);
@@ -563,9 +599,26 @@ bool ChatFilters::loadNextExceptions(bool chatsListLoaded) {
 }
 
 void ChatFilters::refreshHistory(not_null<History*> history) {
-	if (history->inChatList() && !list().empty()) {
-		_owner->refreshChatListEntry(history);
+	if (!history->inChatList() || list().empty()) {
+		return;
+	}
+	const auto i = _historyFlags.find(history);
+	if (i != end(_historyFlags)
+		&& i->second == ChatFilter::HistoryFlags(history)) {
+		// Membership in all filters depends only on these flags.
+		return;
 	}
+	_owner->refreshChatListEntry(history);
+}
+
+ChatFilter::Flags ChatFilters::historyFlags(not_null<History*> history) {
+	const auto result = ChatFilter::HistoryFlags(history);
+	_historyFlags[history] = result;
+	return result;
+}
+
+void ChatFilters::forgetHistories() {
+	_historyFlags.clear();
 }
 
 void ChatFilters::requestSuggested() {
@@ -60,7 +60,13 @@ public:
 	[[nodiscard]] const std::vector<not_null<History*>> &pinned() const;
 	[[nodiscard]] const base::flat_set<not_null<History*>> &never() const;
 
+	// Peer type flag of the history together with the No* rules it passes.
+	[[nodiscard]] static Flags HistoryFlags(not_null<History*> history);
+
 	[[nodiscard]] bool contains(not_null<History*> history) const;
+	[[nodiscard]] bool contains(
+		not_null<History*> history,
+		Flags historyFlags) const;
 
 private:
 	FilterId _id = 0;
@@ -107,6 +113,9 @@ public:
 	bool loadNextExceptions(bool chatsListLoaded);
 
 	void refreshHistory(not_null<History*> history);
+	[[nodiscard]] ChatFilter::Flags historyFlags(
+		not_null<History*> history);
+	void forgetHistories();
 
 	[[nodiscard]] not_null<Dialogs::MainList*> chatsList(FilterId filterId);
 
@@ -151,6 +160,13 @@ private:
 	std::deque<FilterId> _exceptionsToLoad;
 	mtpRequestId _exceptionsLoadRequestId = 0;
 
+	// Flags of each history at the moment its membership was computed.
+	std::unordered_map<
+		not_null<History*>,
+		ChatFilter::Flags> _historyFlags;
+
+	rpl::lifetime _lifetime;
+
 };
 
 } // namespace Data
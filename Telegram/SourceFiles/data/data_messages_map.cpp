@@ -0,0 +1,154 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_messages_map.h"
+
+namespace Data {
+namespace {
+
+constexpr auto kMinCapacity = 64;
+constexpr auto kHashMultiplier = 0x9E3779B97F4A7C15ULL;
+
+// Grow when more than 3/4 of the slots are taken.
+[[nodiscard]] bool Overloaded(int size, int capacity) {
+	return (size * 4 > capacity * 3);
+}
+
+} // namespace
+
+uint64 MessagesMap::Key(FullMsgId id) {
+	return (uint64(uint32(id.channel)) << 32) | uint64(uint32(id.msg));
+}
+
+int MessagesMap::home(uint64 key) const {
+	return int((key * kHashMultiplier) >> _shift);
+}
+
+int MessagesMap::lookup(uint64 key) const {
+	if (_slots.empty()) {
+		return -1;
+	}
+	const auto mask = int(_slots.size()) - 1;
+	for (auto i = home(key); true; i = (i + 1) & mask) {
+		const auto &slot = _slots[i];
+		if (!slot.item) {
+			return -1;
+		} else if (slot.key == key) {
+			return i;
+		}
+	}
+}
+
+HistoryItem *MessagesMap::find(FullMsgId id) const {
+	const auto index = lookup(Key(id));
+	return (index >= 0) ? _slots[index].item : nullptr;
+}
+
+HistoryItemsList MessagesMap::find(const MessageIdsList &ids) const {
+	auto result = HistoryItemsList();
+	if (!_size) {
+		return result;
+	}
+	result.reserve(ids.size());
+	for (const auto &id : ids) {
+		if (const auto item = find(id)) {
+			result.push_back(item);
+		}
+	}
+	return result;
+}
+
+bool MessagesMap::insert(FullMsgId id, not_null<HistoryItem*> item) {
+	if (Overloaded(_size + 1, int(_slots.size()))) {
+		rehash(std::max(int(_slots.size()) * 2, kMinCapacity));
+	}
+	const auto key = Key(id);
+	const auto mask = int(_slots.size()) - 1;
+	for (auto i = home(key); true; i = (i + 1) & mask) {
+		auto &slot = _slots[i];
+		if (!slot.item) {
+			slot.key = key;
+			slot.item = item;
+			++_size;
+			return true;
+		} else if (slot.key == key) {
+			return false;
+		}
+	}
+}
+
+HistoryItem *MessagesMap::take(FullMsgId id) {
+	auto index = lookup(Key(id));
+	if (index < 0) {
+		return nullptr;
+	}
+	const auto result = _slots[index].item;
+	--_size;
+
+	// Shift back the following slots of the probe sequence,
+	// so that no tombstones are needed.
+	const auto mask = int(_slots.size()) - 1;
+	for (auto next = (index + 1) & mask; true; next = (next + 1) & mask) {
+		const auto &slot = _slots[next];
+		if (!slot.item) {
+			break;
+		}
+		const auto wanted = home(slot.key);
+		const auto between = (index <= next)
+			? (wanted > index && wanted <= next)
+			: (wanted > index || wanted <= next);
+		if (!between) {
+			_slots[index] = slot;
+			index = next;
+		}
+	}
+	_slots[index] = Slot();
+	return result;
+}
+
+void MessagesMap::reserve(int count) {
+	auto capacity = std::max(int(_slots.size()), kMinCapacity);
+	while (Overloaded(count, capacity)) {
+		capacity *= 2;
+	}
+	if (capacity != int(_slots.size())) {
+		rehash(capacity);
+	}
+}
+
+int MessagesMap::size() const {
+	return _size;
+}
+
+void MessagesMap::clear() {
+	_slots = std::vector<Slot>();
+	_shift = 64;
+	_size = 0;
+}
+
+void MessagesMap::rehash(int capacity) {
+	Expects(!(capacity & (capacity - 1)));
+
+	auto was = std::exchange(_slots, std::vector<Slot>(capacity));
+	_shift = 64;
+	for (auto i = capacity; i > 1; i >>= 1) {
+		--_shift;
+	}
+	const auto mask = capacity - 1;
+	for (const auto &slot : was) {
+		if (!slot.item) {
+			continue;
+		}
+		auto i = home(slot.key);
+		while (_slots[i].item) {
+			i = (i + 1) & mask;
+		}
+		_slots[i] = slot;
+	}
+}
+
+} // namespace Data
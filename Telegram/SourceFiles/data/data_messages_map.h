@@ -0,0 +1,50 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+class HistoryItem;
+
+namespace Data {
+
+// All the loaded messages by their full ids.
+//
+// One open addressing table with linear probing: a slot is a packed
+// (channel, msg) key with the item pointer, so a lookup is a hash and
+// a short scan of adjacent slots instead of a tree walk to the channel
+// and then a node based hash map lookup.
+class MessagesMap final {
+public:
+	[[nodiscard]] HistoryItem *find(FullMsgId id) const;
+	[[nodiscard]] HistoryItemsList find(const MessageIdsList &ids) const;
+
+	// Returns false if there already is an item with this id.
+	bool insert(FullMsgId id, not_null<HistoryItem*> item);
+	HistoryItem *take(FullMsgId id);
+
+	void reserve(int count);
+	[[nodiscard]] int size() const;
+	void clear();
+
+private:
+	struct Slot {
+		uint64 key = 0;
+		HistoryItem *item = nullptr;
+	};
+
+	[[nodiscard]] static uint64 Key(FullMsgId id);
+	[[nodiscard]] int home(uint64 key) const;
+	[[nodiscard]] int lookup(uint64 key) const;
+	void rehash(int capacity);
+
+	std::vector<Slot> _slots;
+	int _shift = 64;
+	int _size = 0;
+
+};
+
+} // namespace Data
@@ -23,6 +23,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtproto_config.h"
 #include "window/notifications_manager.h"
 #include "history/history.h"
+#include "history/history_memory_pool.h"
 #include "history/history_item_components.h"
 #include "history/view/media/history_view_media.h"
 #include "history/view/history_view_element.h"
@@ -30,6 +31,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "inline_bots/inline_bot_layout_item.h"
 #include "storage/storage_account.h"
 #include "storage/storage_encrypted_file.h"
+#include "storage/storage_messages_index.h"
+#include "storage/storage_messages_cache.h"
 #include "media/player/media_player_instance.h" // instance()->play()
 #include "media/audio/media_audio.h"
 #include "boxes/abstract_box.h"
@@ -67,6 +70,7 @@ namespace {
 
 constexpr auto kMaxNotifyCheckDelay = 24 * 3600 * crl::time(1000);
 constexpr auto kMaxWallpaperSize = 10 * 1024 * 1024;
+constexpr auto kKeepShownHistoriesViewsCount = 5000;
 
 using ViewElement = HistoryView::Element;
 
@@ -132,6 +136,66 @@ std::vector<UnavailableReason> ExtractUnavailableReasons(
 	}) | ranges::to_vector;
 }
 
+[[nodiscard]] PeerId PeerIdFromUser(const MTPUser &data) {
+	return data.match([](const auto &data) {
+		return peerFromUser(data.vid());
+	});
+}
+
+[[nodiscard]] PeerId PeerIdFromChat(const MTPChat &data) {
+	return data.match([](const MTPDchannel &data) {
+		return peerFromChannel(data.vid());
+	}, [](const MTPDchannelForbidden &data) {
+		return peerFromChannel(data.vid());
+	}, [](const auto &data) {
+		return peerFromChat(data.vid());
+	});
+}
+
+template <typename Entry>
+[[nodiscard]] mtpBuffer SerializeEntry(const Entry &entry) {
+	auto result = mtpBuffer();
+	result.reserve(tl::count_length(entry) >> 2);
+	entry.write(result);
+	return result;
+}
+
+// Large responses (dialogs, difference, participants) often mention
+// the same peer several times, mostly with exactly the same data.
+// We skip only the entries repeated byte for byte later in the list:
+// even a complete entry doesn't overwrite everything, for example the
+// access hash and the status are applied only when they're present.
+template <typename Entry, typename IdGetter>
+[[nodiscard]] std::vector<bool> RepeatedEntries(
+		const QVector<Entry> &entries,
+		IdGetter &&id) {
+	auto result = std::vector<bool>(entries.size(), false);
+	auto counts = base::flat_map<PeerId, int>();
+	counts.reserve(entries.size());
+	for (const auto &entry : entries) {
+		++counts[id(entry)];
+	}
+	if (counts.size() == entries.size()) {
+		return result;
+	}
+	auto later = base::flat_map<PeerId, std::vector<mtpBuffer>>();
+	for (auto i = int(entries.size()); i != 0;) {
+		const auto &entry = entries[--i];
+		const auto peerId = id(entry);
+		if (counts[peerId] < 2) {
+			continue;
+		}
+		auto serialized = SerializeEntry(entry);
+		auto &list = later[peerId];
+		if (ranges::contains(list, serialized)) {
+			result[i] = true;
+		} else {
+			list.push_back(std::move(serialized));
+		}
+	}
+	return result;
+}
+
 [[nodiscard]] QByteArray FindInlineThumbnail(
 		const QVector<MTPPhotoSize> &sizes) {
 	const auto i = ranges::find(
@@ -210,6 +274,8 @@ Session::Session(not_null<Main::Session*> session)
 , _bigFileCache(Core::App().databases().get(
 	_session->local().cacheBigFilePath(),
 	_session->local().cacheBigFileSettings()))
+, _messagesIndex(std::make_unique<Storage::MessagesIndex>(session))
+, _messagesCache(std::make_unique<Storage::MessagesCache>(session))
 , _chatsList(
 	session,
 	FilterId(),
@@ -268,11 +334,12 @@ void Session::clear() {
 
 	_sendActions.clear();
 
+	_shownHistories.clear();
+	_chatsFilters->forgetHistories();
 	_histories->unloadAll();
 	_scheduledMessages = nullptr;
 	_dependentMessages.clear();
-	base::take(_messages);
-	base::take(_channelMessages);
+	_messages.clear();
 	_messageByRandomId.clear();
 	_sentMessagesData.clear();
 	cSetRecentInlineBots(RecentInlineBots());
@@ -755,17 +822,37 @@ not_null<PeerData*> Session::processChat(const MTPChat &data) {
 }
 
 UserData *Session::processUsers(const MTPVector<MTPUser> &data) {
+	const auto &list = data.v;
+	if (list.size() < 2) {
+		return list.isEmpty() ? nullptr : processUser(list.front()).get();
+	}
+	_peers.reserve(_peers.size() + list.size());
+	const auto repeated = RepeatedEntries(list, PeerIdFromUser);
+
+	// The last entry is never skipped, so we return the same user
+	// as if all of them were applied.
 	auto result = (UserData*)nullptr;
-	for (const auto &user : data.v) {
-		result = processUser(user);
+	for (auto i = 0, count = int(list.size()); i != count; ++i) {
+		if (!repeated[i]) {
+			result = processUser(list[i]);
+		}
 	}
 	return result;
 }
 
 PeerData *Session::processChats(const MTPVector<MTPChat> &data) {
+	const auto &list = data.v;
+	if (list.size() < 2) {
+		return list.isEmpty() ? nullptr : processChat(list.front()).get();
+	}
+	_peers.reserve(_peers.size() + list.size());
+	const auto repeated = RepeatedEntries(list, PeerIdFromChat);
+
 	auto result = (PeerData*)nullptr;
-	for (const auto &chat : data.v) {
-		result = processChat(chat);
+	for (auto i = 0, count = int(list.size()); i != count; ++i) {
+		if (!repeated[i]) {
+			result = processChat(list[i]);
+		}
 	}
 	return result;
 }
@@ -1314,12 +1401,9 @@ rpl::producer<not_null<HistoryItem*>> Session::unreadItemAdded() const {
 }
 
 void Session::changeMessageId(ChannelId channel, MsgId wasId, MsgId nowId) {
-	const auto list = messagesListForInsert(channel);
-	auto i = list->find(wasId);
-	Assert(i != list->end());
-	auto owned = std::move(i->second);
-	list->erase(i);
-	const auto [j, ok] = list->emplace(nowId, std::move(owned));
+	const auto item = _messages.take(FullMsgId(channel, wasId));
+	Assert(item != nullptr);
+	const auto ok = _messages.insert(FullMsgId(channel, nowId), item);
 
 	Ensures(ok);
 }
@@ -1581,15 +1665,7 @@ rpl::producer<not_null<UserData*>> Session::megagroupParticipantAdded(
 
 HistoryItemsList Session::idsToItems(
 		const MessageIdsList &ids) const {
-	return ranges::view::all(
-		ids
-	) | ranges::view::transform([&](const FullMsgId &fullId) {
-		return message(fullId);
-	}) | ranges::view::filter([](HistoryItem *item) {
-		return item != nullptr;
-	}) | ranges::view::transform([](HistoryItem *item) {
-		return not_null<HistoryItem*>(item);
-	}) | ranges::to_vector;
+	return _messages.find(ids);
 }
 
 MessageIdsList Session::itemsToIds(
@@ -1822,7 +1898,8 @@ void Session::updateEditedMessage(const MTPMessage &data) {
 void Session::processMessages(
 		const QVector<MTPMessage> &data,
 		NewMessageType type) {
-	auto indices = base::flat_map<uint64, int>();
+	auto indices = std::vector<std::pair<uint64, int>>();
+	indices.reserve(data.size());
 	for (int i = 0, l = data.size(); i != l; ++i) {
 		const auto &message = data[i];
 		if (message.type() == mtpc_message) {
@@ -1834,9 +1911,14 @@ void Session::processMessages(
 			}
 		}
 		const auto id = IdFromMessage(message);
-		indices.emplace((uint64(uint32(id)) << 32) | uint64(i), i);
+		indices.emplace_back((uint64(uint32(id)) << 32) | uint64(i), i);
 	}
-	for (const auto [position, index] : indices) {
+
+	// Positions are unique, so sorting gives the same order as flat_map
+	// without inserting one by one, and the messages map grows only once.
+	ranges::sort(indices);
+	_messages.reserve(_messages.size() + int(indices.size()));
+	for (const auto &[position, index] : indices) {
 		addNewMessage(
 			data[index],
 			MTPDmessage_ClientFlags(),
@@ -1850,49 +1932,28 @@ void Session::processMessages(
 	processMessages(data.v, type);
 }
 
-const Session::Messages *Session::messagesList(ChannelId channelId) const {
-	if (channelId == NoChannel) {
-		return &_messages;
-	}
-	const auto i = _channelMessages.find(channelId);
-	return (i != end(_channelMessages)) ? &i->second : nullptr;
-}
-
-auto Session::messagesListForInsert(ChannelId channelId)
--> not_null<Messages*> {
-	return (channelId == NoChannel)
-		? &_messages
-		: &_channelMessages[channelId];
-}
-
 void Session::registerMessage(not_null<HistoryItem*> item) {
-	const auto list = messagesListForInsert(item->channelId());
-	const auto itemId = item->id;
-	const auto i = list->find(itemId);
-	if (i != list->end()) {
+	const auto itemId = item->fullId();
+	if (const auto existing = _messages.find(itemId)) {
 		LOG(("App Error: Trying to re-registerMessage()."));
-		i->second->destroy();
+		existing->destroy();
 	}
-	list->emplace(itemId, item);
+	_messages.insert(itemId, item);
 }
 
 void Session::processMessagesDeleted(
 		ChannelId channelId,
 		const QVector<MTPint> &data) {
-	const auto list = messagesList(channelId);
 	const auto affected = (channelId != NoChannel)
 		? historyLoaded(peerFromChannel(channelId))
 		: nullptr;
-	if (!list && !affected) {
-		return;
-	}
 
 	auto historiesToCheck = base::flat_set<not_null<History*>>();
 	for (const auto messageId : data) {
-		const auto i = list ? list->find(messageId.v) : Messages::iterator();
-		if (list && i != list->end()) {
-			const auto history = i->second->history();
-			i->second->destroy();
+		const auto item = _messages.find(FullMsgId(channelId, messageId.v));
+		if (item) {
+			const auto history = item->history();
+			item->destroy();
 			if (!history->chatListMessageKnown()) {
 				historiesToCheck.emplace(history);
 			}
@@ -1926,7 +1987,7 @@ void Session::unregisterMessage(not_null<HistoryItem*> item) {
 		Data::MessageUpdate::Flag::Destroyed);
 	groups().unregisterMessage(item);
 	removeDependencyMessage(item);
-	messagesListForInsert(peerToChannel(peerId))->erase(item->id);
+	_messages.take(FullMsgId(peerToChannel(peerId), item->id));
 }
 
 MsgId Session::nextLocalMessageId() {
@@ -1940,13 +2001,7 @@ HistoryItem *Session::message(ChannelId channelId, MsgId itemId) const {
 		return nullptr;
 	}
 
-	const auto data = messagesList(channelId);
-	if (!data) {
-		return nullptr;
-	}
-
-	const auto i = data->find(itemId);
-	return (i != data->end()) ? i->second.get() : nullptr;
+	return _messages.find(FullMsgId(channelId, itemId));
 }
 
 HistoryItem *Session::message(
@@ -3466,6 +3521,56 @@ void Session::registerItemView(not_null<ViewElement*> view) {
 	_views[view->data()].push_back(view);
 }
 
+void Session::historyShown(not_null<History*> history) {
+	_shownHistories.erase(
+		ranges::remove(_shownHistories, history),
+		end(_shownHistories));
+	_shownHistories.insert(begin(_shownHistories), history);
+
+	if (Logs::DebugEnabled()) {
+		const auto report = history->memoryReport();
+		const auto items = HistoryView::ItemsMemoryPool().stats();
+		const auto views = HistoryView::ViewsMemoryPool().stats();
+		DEBUG_LOG(("Memory Info: history %1, messages %2, services %3, "
+			"views %4, blocks %5, bytes %6; "
+			"items pool %7 / %8 bytes, views pool %9 / %10 bytes."
+			).arg(history->peer->id
+			).arg(report.messages
+			).arg(report.services
+			).arg(report.views
+			).arg(report.blocks
+			).arg(report.bytes
+			).arg(items.used
+			).arg(items.reserved
+			).arg(views.used
+			).arg(views.reserved));
+
+		const auto changes = session().changes().fanOut();
+		DEBUG_LOG(("Changes Info: notifications %1, keyed deliveries %2, "
+			"max %3 deliveries for one notification."
+			).arg(changes.notifications
+			).arg(changes.keyedDeliveries
+			).arg(changes.maxKeyedDeliveries));
+	}
+
+	const auto migrated = history->migrateFrom();
+	auto count = 0;
+	for (auto i = begin(_shownHistories); i != end(_shownHistories);) {
+		const auto shown = *i;
+		if (shown == history || shown == migrated) {
+			++i;
+			continue;
+		}
+		count += shown->loadedViewsCount();
+		if (count > kKeepShownHistoriesViewsCount) {
+			shown->unloadBlocks();
+			i = _shownHistories.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
 void Session::unregisterItemView(not_null<ViewElement*> view) {
 	Expects(!_heavyViewParts.contains(view));
 
@@ -3573,11 +3678,15 @@ void Session::refreshChatListEntry(Dialogs::Key key) {
 	if (!history) {
 		return;
 	}
-	for (const auto &filter : _chatsFilters->list()) {
+	const auto &filters = _chatsFilters->list();
+	const auto flags = filters.empty()
+		? ChatFilter::Flags()
+		: _chatsFilters->historyFlags(history);
+	for (const auto &filter : filters) {
 		const auto id = filter.id();
 		const auto filterList = chatsFilters().chatsList(id);
 		auto event = ChatListEntryRefresh{ .key = key, .filterId = id };
-		if (filter.contains(history)) {
+		if (filter.contains(history, flags)) {
 			event.existenceChanged = !entry->inChatList(id);
 			if (event.existenceChanged) {
 				entry->addToChatList(id, filterList);
@@ -3989,6 +4098,8 @@ void Session::clearLocalStorage() {
 	_cache->clear();
 	_bigFileCache->close();
 	_bigFileCache->clear();
+	_messagesIndex->clear();
+	_messagesCache->clear();
 }
 
 } // namespace Data
@@ -14,6 +14,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_groups.h"
 #include "data/data_cloud_file.h"
 #include "data/data_notify_settings.h"
+#include "data/data_messages_map.h"
 #include "history/history_location_manager.h"
 #include "base/timer.h"
 #include "base/flags.h"
@@ -42,6 +43,11 @@ namespace Ui {
 class BoxContent;
 } // namespace Ui
 
+namespace Storage {
+class MessagesIndex;
+class MessagesCache;
+} // namespace Storage
+
 namespace Passport {
 struct SavedCredentials;
 } // namespace Passport
@@ -125,6 +131,12 @@ public:
 
 	[[nodiscard]] Storage::Cache::Database &cache();
 	[[nodiscard]] Storage::Cache::Database &cacheBigFile();
+	[[nodiscard]] Storage::MessagesIndex &messagesIndex() const {
+		return *_messagesIndex;
+	}
+	[[nodiscard]] Storage::MessagesCache &messagesCache() const {
+		return *_messagesCache;
+	}
 
 	[[nodiscard]] not_null<PeerData*> peer(PeerId id);
 	[[nodiscard]] not_null<PeerData*> peer(UserId id) = delete;
@@ -568,6 +580,9 @@ public:
 	void registerItemView(not_null<ViewElement*> view);
 	void unregisterItemView(not_null<ViewElement*> view);
 
+	// Unloads least recently shown histories above the global budget.
+	void historyShown(not_null<History*> history);
+
 	[[nodiscard]] not_null<Folder*> folder(FolderId id);
 	[[nodiscard]] Folder *folderLoaded(FolderId id) const;
 	not_null<Folder*> processFolder(const MTPFolder &data);
@@ -647,8 +662,6 @@ public:
 	void clearLocalStorage();
 
 private:
-	using Messages = std::unordered_map<MsgId, not_null<HistoryItem*>>;
-
 	void suggestStartExport();
 
 	void setupMigrationViewer();
@@ -666,8 +679,6 @@ private:
 		Data::Folder *requestFolder,
 		const MTPDdialogFolder &data);
 
-	const Messages *messagesList(ChannelId channelId) const;
-	not_null<Messages*> messagesListForInsert(ChannelId channelId);
 	not_null<HistoryItem*> registerMessage(
 		std::unique_ptr<HistoryItem> item);
 	void changeMessageId(ChannelId channel, MsgId wasId, MsgId nowId);
@@ -786,6 +797,8 @@ private:
 
 	Storage::DatabasePointer _cache;
 	Storage::DatabasePointer _bigFileCache;
+	const std::unique_ptr<Storage::MessagesIndex> _messagesIndex;
+	const std::unique_ptr<Storage::MessagesCache> _messagesCache;
 
 	TimeId _exportAvailableAt = 0;
 	QPointer<Ui::BoxContent> _exportSuggestion;
@@ -824,8 +837,7 @@ private:
 	Dialogs::IndexedList _contactsNoChatsList;
 
 	MsgId _localMessageIdCounter = StartClientMsgId;
-	Messages _messages;
-	std::map<ChannelId, Messages> _channelMessages;
+	MessagesMap _messages;
 	std::map<
 		not_null<HistoryItem*>,
 		base::flat_set<not_null<HistoryItem*>>> _dependentMessages;
@@ -906,6 +918,9 @@ private:
 
 	base::flat_set<not_null<ViewElement*>> _heavyViewParts;
 
+	// Most recently shown first.
+	std::vector<not_null<History*>> _shownHistories;
+
 	History *_topPromoted = nullptr;
 
 	NotifySettings _defaultUserNotifySettings;
@@ -1934,8 +1934,15 @@ InnerWidget::~InnerWidget() {
 }
 
 void InnerWidget::clearSearchResults(bool clearPeerSearchResults) {
-	if (clearPeerSearchResults) _peerSearchResults.clear();
+	if (clearPeerSearchResults) {
+		_peerSearchResults.clear();
+		_localSearchResults.clear();
+	}
 	_searchResults.clear();
+	_searchResultsInjected = false;
+	_localSearchMergeDate = 0;
+	_localOnlySearchResults.clear();
+	_searchedServerCount = -1;
 	_searchedCount = _searchedMigratedCount = 0;
 	_lastSearchDate = 0;
 	_lastSearchPeer = nullptr;
@@ -1994,24 +2001,113 @@ void InnerWidget::visibleTopBottomUpdated(
 }
 
 void InnerWidget::itemRemoved(not_null<const HistoryItem*> item) {
+	_localSearchResults.erase(
+		ranges::remove_if(_localSearchResults, [&](
+				not_null<HistoryItem*> local) {
+			return (local == item);
+		}),
+		end(_localSearchResults));
+
 	int wasCount = _searchResults.size();
 	for (auto i = _searchResults.begin(); i != _searchResults.end();) {
 		if ((*i)->item() == item) {
 			i = _searchResults.erase(i);
 			if (item->history() == _searchInMigrated) {
 				if (_searchedMigratedCount > 0) --_searchedMigratedCount;
-			} else {
-				if (_searchedCount > 0) --_searchedCount;
+			} else if (!_localOnlySearchResults.remove(item->fullId())) {
+				if (_searchedServerCount > 0) --_searchedServerCount;
 			}
 		} else {
 			++i;
 		}
 	}
 	if (wasCount != _searchResults.size()) {
+		refreshSearchedCount();
 		refresh();
 	}
 }
 
+void InnerWidget::localSearchReceived(
+		std::vector<not_null<HistoryItem*>> items,
+		bool mergeWithServer) {
+	_localSearchResults = std::move(items);
+	if (_state != WidgetState::Filtered) {
+		return;
+	}
+	if (!mergeWithServer) {
+		// Results of the previous query are outdated already.
+		clearSearchResults(false);
+	}
+	if (mergeLocalSearchResults(_localSearchMergeDate)) {
+		refreshSearchedCount();
+		_waitingForSearch = false;
+		refresh();
+	}
+}
+
+void InnerWidget::serverSearchFinished() {
+	_localSearchMergeDate = 0;
+	mergeLocalSearchResults(0);
+	refreshSearchedCount();
+	refresh();
+}
+
+int InnerWidget::mergeLocalSearchResults(TimeId minDate) {
+	if (uniqueSearchResults()) {
+		return 0;
+	}
+	auto added = 0;
+	for (const auto item : _localSearchResults) {
+		if (minDate && item->date() < minDate) {
+			break;
+		} else if (hasItemInSearchResults(item)) {
+			continue;
+		}
+		_searchResults.push_back(
+			std::make_unique<FakeRow>(_searchInChat, item));
+		_localOnlySearchResults.emplace(item->fullId());
+		++added;
+	}
+	if (added) {
+		const auto from = begin(_searchResults)
+			+ (_searchResultsInjected ? 1 : 0);
+		ranges::stable_sort(from, end(_searchResults), [](
+				const std::unique_ptr<FakeRow> &a,
+				const std::unique_ptr<FakeRow> &b) {
+			return (a->item()->date() > b->item()->date());
+		});
+	}
+	return added;
+}
+
+void InnerWidget::refreshSearchedCount() {
+	// The server counts the local results as well, except for the ones
+	// it didn't return in the pages that already cover their dates.
+	const auto counted = [&](not_null<HistoryItem*> item) {
+		return (_searchedServerCount >= 0)
+			&& _localSearchMergeDate
+			&& (item->date() < _localSearchMergeDate);
+	};
+	auto result = std::max(_searchedServerCount, 0);
+	for (const auto &row : _searchResults) {
+		const auto item = row->item();
+		if (_localOnlySearchResults.contains(item->fullId())
+			&& !counted(item)) {
+			++result;
+		}
+	}
+	_searchedCount = result;
+}
+
+bool InnerWidget::hasItemInSearchResults(
+		not_null<HistoryItem*> item) const {
+	return ranges::find(
+		_searchResults,
+		item,
+		[](const std::unique_ptr<FakeRow> &row) { return row->item(); }
+	) != end(_searchResults);
+}
+
 bool InnerWidget::uniqueSearchResults() const {
 	return _controller->uniqueChatsInSearchResults();
 }
@@ -2066,6 +2162,7 @@ bool InnerWidget::searchReceived(
 			std::make_unique<FakeRow>(
 				_searchInChat,
 				inject));
+		_searchResultsInjected = true;
 		++fullCount;
 	}
 	for (const auto &message : messages) {
@@ -2079,7 +2176,10 @@ bool InnerWidget::searchReceived(
 					MTPDmessage_ClientFlags(),
 					NewMessageType::Existing);
 				const auto history = item->history();
-				if (!uniquePeers || !hasHistoryInResults(history)) {
+				if (hasItemInSearchResults(item)) {
+					// Already shown from the local search index.
+					_localOnlySearchResults.remove(item->fullId());
+				} else if (!uniquePeers || !hasHistoryInResults(history)) {
 					_searchResults.push_back(
 						std::make_unique<FakeRow>(
 							_searchInChat,
@@ -2108,7 +2208,11 @@ bool InnerWidget::searchReceived(
 	if (isMigratedSearch) {
 		_searchedMigratedCount = fullCount;
 	} else {
-		_searchedCount = fullCount;
+		// Local results older than this page wait for the next one.
+		_localSearchMergeDate = lastDateFound;
+		_searchedServerCount = fullCount;
+		mergeLocalSearchResults(_localSearchMergeDate);
+		refreshSearchedCount();
 	}
 	if (_waitingForSearch
 		&& (!_searchResults.empty()
@@ -73,6 +73,10 @@ public:
 		HistoryItem *inject,
 		SearchRequestType type,
 		int fullCount);
+	void localSearchReceived(
+		std::vector<not_null<HistoryItem*>> items,
+		bool mergeWithServer);
+	void serverSearchFinished();
 	void peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
@@ -306,6 +310,10 @@ private:
 	void refreshSearchInChatLabel();
 
 	void clearSearchResults(bool clearPeerSearchResults = true);
+	int mergeLocalSearchResults(TimeId minDate);
+	void refreshSearchedCount();
+	[[nodiscard]] bool hasItemInSearchResults(
+		not_null<HistoryItem*> item) const;
 	void updateSelectedRow(Key key = Key());
 
 	not_null<IndexedList*> shownDialogs() const;
@@ -377,6 +385,11 @@ private:
 	int _peerSearchPressed = -1;
 
 	std::vector<std::unique_ptr<FakeRow>> _searchResults;
+	std::vector<not_null<HistoryItem*>> _localSearchResults;
+	TimeId _localSearchMergeDate = 0;
+	bool _searchResultsInjected = false;
+	base::flat_set<FullMsgId> _localOnlySearchResults;
+	int _searchedServerCount = -1;
 	int _searchedCount = 0;
 	int _searchedMigratedCount = 0;
 	int _searchedSelected = -1;
@@ -0,0 +1,137 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Dialogs {
+
+// Finds values by prefixes of their name words.
+//
+// Words are kept in a sorted dictionary, so all the words starting with
+// a prefix form one contiguous range in it. A query is answered from the
+// range of its most selective word and only those candidates are checked
+// against the rest of the query words. Transliterated and layout-switched
+// forms come already in PeerData::nameWords().
+template <typename Value>
+class SearchIndex final {
+public:
+	void add(Value value, const base::flat_set<QString> &words) {
+		remove(value);
+		if (words.empty()) {
+			return;
+		}
+		auto &list = _values[value];
+		list.reserve(words.size());
+		for (const auto &word : words) {
+			list.push_back(word);
+			_words[word].push_back(value);
+		}
+	}
+	void remove(Value value) {
+		const auto i = _values.find(value);
+		if (i == end(_values)) {
+			return;
+		}
+		for (const auto &word : i->second) {
+			const auto j = _words.find(word);
+			if (j == end(_words)) {
+				continue;
+			}
+			auto &bucket = j->second;
+			bucket.erase(ranges::remove(bucket, value), end(bucket));
+			if (bucket.empty()) {
+				_words.erase(j);
+			}
+		}
+		_values.erase(i);
+	}
+	void clear() {
+		_words.clear();
+		_values.clear();
+	}
+
+	[[nodiscard]] bool empty() const {
+		return _values.empty();
+	}
+
+	// Values having a name word starting with each of the query words,
+	// in no particular order.
+	[[nodiscard]] std::vector<Value> find(const QStringList &query) const {
+		auto result = std::vector<Value>();
+		auto best = QString();
+		auto bestCount = -1;
+		for (const auto &word : query) {
+			if (word.isEmpty()) {
+				continue;
+			}
+			const auto count = countPrefix(word);
+			if (!count) {
+				return result;
+			} else if (bestCount < 0 || count < bestCount) {
+				best = word;
+				bestCount = count;
+			}
+		}
+		if (bestCount < 0) {
+			return result;
+		}
+		result.reserve(bestCount);
+		enumeratePrefix(best, [&](const std::vector<Value> &bucket) {
+			result.insert(end(result), begin(bucket), end(bucket));
+		});
+		ranges::sort(result);
+		result.erase(ranges::unique(result), end(result));
+
+		const auto matches = [&](Value value) {
+			const auto &words = _values.find(value)->second;
+			const auto found = [&](const QString &word) {
+				for (const auto &name : words) {
+					if (name.startsWith(word)) {
+						return true;
+					}
+				}
+				return false;
+			};
+			for (const auto &word : query) {
+				if (!word.isEmpty() && word != best && !found(word)) {
+					return false;
+				}
+			}
+			return true;
+		};
+		result.erase(
+			ranges::remove_if(result, [&](Value value) {
+				return !matches(value);
+			}),
+			end(result));
+		return result;
+	}
+
+private:
+	template <typename Callback>
+	void enumeratePrefix(const QString &prefix, Callback &&callback) const {
+		for (auto i = _words.lower_bound(prefix); i != end(_words); ++i) {
+			if (!i->first.startsWith(prefix)) {
+				break;
+			}
+			callback(i->second);
+		}
+	}
+	[[nodiscard]] int countPrefix(const QString &prefix) const {
+		auto result = 0;
+		enumeratePrefix(prefix, [&](const std::vector<Value> &bucket) {
+			result += int(bucket.size());
+		});
+		return result;
+	}
+
+	std::map<QString, std::vector<Value>> _words;
+	std::unordered_map<Value, std::vector<QString>> _values;
+
+};
+
+} // namespace Dialogs
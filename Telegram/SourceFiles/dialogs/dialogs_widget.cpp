@@ -35,6 +35,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "window/window_main_menu.h"
 #include "storage/storage_media_prepare.h"
 #include "storage/storage_account.h"
+#include "storage/storage_messages_index.h"
 #include "data/data_session.h"
 #include "data/data_channel.h"
 #include "data/data_chat.h"
@@ -789,6 +790,7 @@ void Widget::onDraggingScrollTimer() {
 bool Widget::onSearchMessages(bool searchCache) {
 	auto result = false;
 	auto q = _filter->getLastText().trimmed();
+	searchLocal(q);
 	if (q.isEmpty() && !_searchFromUser) {
 		cancelSearchRequest();
 		_api.request(base::take(_peerSearchRequest)).cancel();
@@ -1151,6 +1153,10 @@ void Widget::searchReceived(
 	if (_searchRequest != requestId) {
 		return;
 	}
+	if (type == SearchRequestType::FromStart
+		|| type == SearchRequestType::PeerFromStart) {
+		_searchResultsQuery = _searchQuery;
+	}
 	switch (result.type()) {
 	case mtpc_messages_messages: {
 		auto &d = result.c_messages_messages();
@@ -1234,11 +1240,31 @@ void Widget::searchReceived(
 	} break;
 	}
 
+	if (_searchFull) {
+		_inner->serverSearchFinished();
+	}
+
 	_searchRequest = 0;
 	onListScroll();
 	update();
 }
 
+void Widget::searchLocal(const QString &query) {
+	if (_localSearchQuery == query) {
+		return;
+	}
+	_localSearchQuery = query;
+	if (query.isEmpty() || _searchFromUser) {
+		return;
+	}
+	const auto peer = _searchInChat.peer();
+	_inner->localSearchReceived(
+		session().data().messagesIndex().search(
+			query,
+			peer ? peer->id : PeerId()),
+		(_searchResultsQuery == query));
+}
+
 void Widget::peerSearchReceived(
 		const MTPcontacts_Found &result,
 		mtpRequestId requestId) {
@@ -1452,6 +1478,8 @@ void Widget::clearSearchCache() {
 		session().api().request(requestId).cancel();
 	}
 	_searchQuery = QString();
+	_searchResultsQuery = QString();
+	_localSearchQuery = QString();
 	_searchQueryFrom = nullptr;
 	cancelSearchRequest();
 }
@@ -168,6 +168,7 @@ private:
 		SearchRequestType type,
 		const RPCError &error,
 		mtpRequestId requestId);
+	void searchLocal(const QString &query);
 	void peopleFailed(const RPCError &error, mtpRequestId requestId);
 
 	void scrollToTop();
@@ -222,6 +223,8 @@ private:
 	mtpRequestId _peerSearchRequest = 0;
 
 	QString _searchQuery;
+	QString _searchResultsQuery;
+	QString _localSearchQuery;
 	UserData *_searchQueryFrom = nullptr;
 	int32 _searchNextRate = 0;
 	bool _searchFull = false;
@@ -11,6 +11,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/data/export_data_types.h"
 #include "export/output/export_output_result.h"
 #include "export/output/export_output_file.h"
+#include "export/output/export_output_checkpoint.h"
 #include "mtproto/mtproto_rpc_sender.h"
 #include "base/value_ordering.h"
 #include "base/bytes.h"
@@ -22,8 +23,6 @@ namespace {
 
 constexpr auto kUserpicsSliceLimit = 100;
 constexpr auto kFileChunkSize = 128 * 1024;
-constexpr auto kFileRequestsCount = 2;
-constexpr auto kFileNextRequestDelay = crl::time(20);
 constexpr auto kChatsSliceLimit = 100;
 constexpr auto kMessagesSliceLimit = 100;
 constexpr auto kTopPeerSliceLimit = 100;
@@ -45,6 +44,10 @@ std::tuple<const uint64 &, const uint64 &> value_ordering_helper(const LocationK
 		value.id);
 }
 
+inline bool operator==(const LocationKey &a, const LocationKey &b) {
+	return (a.type == b.type) && (a.id == b.id);
+}
+
 LocationKey ComputeLocationKey(const Data::FileLocation &value) {
 	auto result = LocationKey();
 	result.type = value.dcId;
@@ -92,6 +95,51 @@ LocationKey ComputeLocationKey(const Data::FileLocation &value) {
 	return result;
 }
 
+// Takeout files have no id, they can't be found in the checkpoint.
+[[nodiscard]] std::optional<Output::Checkpoint::FileKey> CheckpointFileKey(
+		const Data::FileLocation &location) {
+	if (!location
+		|| location.data.type() == mtpc_inputTakeoutFileLocation) {
+		return std::nullopt;
+	}
+	const auto key = ComputeLocationKey(location);
+	return Output::Checkpoint::FileKey{ key.type, key.id };
+}
+
+// The same location always gets the same path in the shared folder,
+// even in different exports, so each file is written there only once.
+[[nodiscard]] QString SharedMediaPath(const Data::File &file) {
+	if (!file.location
+		|| file.location.data.type() == mtpc_inputTakeoutFileLocation) {
+		return file.suggestedPath;
+	}
+	const auto &path = file.suggestedPath;
+	const auto slash = path.lastIndexOf('/');
+	const auto kind = (slash > 0)
+		? path.mid(0, slash).section('/', -1)
+		: QString();
+	const auto suffix = QFileInfo(path.mid(slash + 1)).suffix();
+	const auto key = ComputeLocationKey(file.location);
+	return "media/"
+		+ (kind.isEmpty() ? QString() : (kind + '/'))
+		+ QString::number(key.id, 16)
+		+ '_'
+		+ QString::number(key.type, 16)
+		+ (suffix.isEmpty() ? QString() : ('.' + suffix));
+}
+
+[[nodiscard]] int MessageFileKey(int index, bool thumb) {
+	return index * 2 + (thumb ? 1 : 0);
+}
+
+[[nodiscard]] int MessageFileIndex(int key) {
+	return key / 2;
+}
+
+[[nodiscard]] bool MessageFileIsThumb(int key) {
+	return (key % 2) != 0;
+}
+
 Settings::Type SettingsFromDialogsType(Data::DialogInfo::Type type) {
 	using DialogType = Data::DialogInfo::Type;
 	switch (type) {
@@ -180,6 +228,10 @@ struct ApiWrap::FileProcess {
 	Fn<bool(FileProgress)> progress;
 	FnMut<void(const QString &relativePath)> done;
 
+	// Loads of the same location started while this one is in flight.
+	std::vector<FnMut<void(const QString &relativePath)>> sameFileDone;
+
+	uint64 id = 0;
 	Data::FileLocation location;
 	Data::FileOrigin origin;
 	int offset = 0;
@@ -195,6 +247,7 @@ struct ApiWrap::FileProcess {
 struct ApiWrap::FileProgress {
 	int ready = 0;
 	int total = 0;
+	QString path;
 };
 
 struct ApiWrap::ChatsProcess {
@@ -229,13 +282,33 @@ struct ApiWrap::ChatProcess {
 
 	FnMut<void(MTPmessages_Messages&&)> requestDone;
 
+	// Dialogs after the one being written are loaded in background,
+	// their slices wait in 'ready' until the dialog is requested.
+	bool background = false;
+	bool countsLoaded = false;
+	bool finished = false;
+	std::deque<Data::MessagesSlice> ready;
+
 	int localSplitIndex = 0;
+
+	// Next slices are requested while files of the current one are loaded.
+	struct PrefetchedSlice {
+		Data::MessagesSlice slice;
+		int localSplitIndex = 0;
+	};
+	std::deque<PrefetchedSlice> prefetched;
+	int requestSplitIndex = 0;
 	int32 largestIdPlusOne = 1;
+	bool requesting = false;
+	bool waitingForSlice = true;
+	bool paused = false;
 
 	Data::ParseMediaContext context;
 	std::optional<Data::MessagesSlice> slice;
-	bool lastSlice = false;
 	int fileIndex = 0;
+
+	// Files of the current slice being loaded, by MessageFileKey().
+	base::flat_map<int, FileProgress> filesLoading;
 };
 
 
@@ -377,7 +450,10 @@ auto ApiWrap::splitRequest(int index, Request &&request) {
 		std::forward<Request>(request)));
 }
 
-auto ApiWrap::fileRequest(const Data::FileLocation &location, int offset) {
+auto ApiWrap::fileRequest(
+		uint64 processId,
+		const Data::FileLocation &location,
+		int offset) {
 	Expects(location.dcId != 0
 		|| location.data.type() == mtpc_inputTakeoutFileLocation);
 	Expects(_takeoutId.has_value());
@@ -393,6 +469,7 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int offset) {
 		if (result.type() == qstr("TAKEOUT_FILE_EMPTY")
 			&& _otherDataProcess != nullptr) {
 			filePartDone(
+				processId,
 				0,
 				MTP_upload_file(
 					MTP_storage_filePartial(),
@@ -400,10 +477,10 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int offset) {
 					MTP_bytes()));
 		} else if (result.type() == qstr("LOCATION_INVALID")
 			|| result.type() == qstr("VERSION_INVALID")) {
-			filePartUnavailable();
+			filePartUnavailable(processId);
 		} else if (result.code() == 400
 			&& result.type().startsWith(qstr("FILE_REFERENCE_"))) {
-			filePartRefreshReference(offset);
+			filePartRefreshReference(processId, offset);
 		} else {
 			error(std::move(result));
 		}
@@ -426,12 +503,14 @@ rpl::producer<Output::Result> ApiWrap::ioErrors() const {
 void ApiWrap::startExport(
 		const Settings &settings,
 		Output::Stats *stats,
+		Output::Checkpoint *checkpoint,
 		FnMut<void(StartInfo)> done) {
 	Expects(_settings == nullptr);
 	Expects(_startProcess == nullptr);
 
 	_settings = std::make_unique<Settings>(settings);
 	_stats = stats;
+	_checkpoint = checkpoint;
 	_startProcess = std::make_unique<StartProcess>();
 	_startProcess->done = std::move(done);
 
@@ -842,7 +921,6 @@ void ApiWrap::finishUserpicsSlice() {
 }
 
 bool ApiWrap::loadUserpicProgress(FileProgress progress) {
-	Expects(_fileProcess != nullptr);
 	Expects(_userpicsProcess != nullptr);
 	Expects(_userpicsProcess->slice.has_value());
 	Expects((_userpicsProcess->fileIndex >= 0)
@@ -850,7 +928,7 @@ bool ApiWrap::loadUserpicProgress(FileProgress progress) {
 			< _userpicsProcess->slice->list.size()));
 
 	return _userpicsProcess->fileProgress(DownloadProgress{
-		_fileProcess->relativePath,
+		progress.path,
 		_userpicsProcess->fileIndex,
 		progress.ready,
 		progress.total });
@@ -962,31 +1040,87 @@ void ApiWrap::requestMessages(
 		Fn<bool(Data::MessagesSlice&&)> slice,
 		FnMut<void()> done) {
 	Expects(_chatProcess == nullptr);
-	Expects(_selfId.has_value());
 
-	_chatProcess = std::make_unique<ChatProcess>();
-	_chatProcess->context.selfPeerId = Data::UserPeerId(*_selfId);
-	_chatProcess->info = info;
-	_chatProcess->start = std::move(start);
-	_chatProcess->fileProgress = std::move(progress);
-	_chatProcess->handleSlice = std::move(slice);
-	_chatProcess->done = std::move(done);
+	const auto i = ranges::find(
+		_chatProcessesAhead,
+		info.relativePath,
+		[](const std::unique_ptr<ChatProcess> &process) {
+			return process->info.relativePath;
+		});
+	const auto prefetched = (i != end(_chatProcessesAhead));
+	if (prefetched) {
+		_chatProcess = std::move(*i);
+		_chatProcessesAhead.erase(i);
+	} else {
+		_chatProcess = createChatProcess(info);
+	}
+	const auto process = _chatProcess.get();
+	process->background = false;
+	process->start = std::move(start);
+	process->fileProgress = std::move(progress);
+	process->handleSlice = std::move(slice);
+	process->done = std::move(done);
+
+	if (!prefetched) {
+		requestMessagesCount(process, 0);
+	} else if (process->countsLoaded) {
+		startMessages(process);
+	}
+}
+
+void ApiWrap::prefetchMessages(const Data::DialogInfo &info) {
+	const auto already = [&](const std::unique_ptr<ChatProcess> &process) {
+		return process && (process->info.relativePath == info.relativePath);
+	};
+	if (already(_chatProcess)
+		|| ranges::any_of(_chatProcessesAhead, already)
+		|| (_chatProcessesAhead.size() + 1 >= _settings->dialogsInFlight)) {
+		return;
+	}
+	_chatProcessesAhead.push_back(createChatProcess(info));
+	const auto process = _chatProcessesAhead.back().get();
+	process->background = true;
+	requestMessagesCount(process, 0);
+}
+
+void ApiWrap::pauseMessages() {
+	_messagesPaused = true;
+}
+
+void ApiWrap::resumeMessages() {
+	_messagesPaused = false;
+
+	const auto process = _chatProcess.get();
+	if (!process || !base::take(process->paused)) {
+		return;
+	}
+	process->waitingForSlice = true;
+	requestMessagesSlice(process);
+	loadNextMessagesSlice(process);
+}
+
+auto ApiWrap::createChatProcess(const Data::DialogInfo &info) const
+-> std::unique_ptr<ChatProcess> {
+	Expects(_selfId.has_value());
 
-	requestMessagesCount(0);
+	auto result = std::make_unique<ChatProcess>();
+	result->context.selfPeerId = Data::UserPeerId(*_selfId);
+	result->info = info;
+	return result;
 }
 
-void ApiWrap::requestMessagesCount(int localSplitIndex) {
-	Expects(_chatProcess != nullptr);
-	Expects(localSplitIndex < _chatProcess->info.splits.size());
+void ApiWrap::requestMessagesCount(
+		not_null<ChatProcess*> process,
+		int localSplitIndex) {
+	Expects(localSplitIndex < process->info.splits.size());
 
 	requestChatMessages(
-		_chatProcess->info.splits[localSplitIndex],
+		process,
+		process->info.splits[localSplitIndex],
 		0, // offset_id
 		0, // add_offset
 		1, // limit
 		[=](const MTPmessages_Messages &result) {
-		Expects(_chatProcess != nullptr);
-
 		const auto count = result.match(
 			[](const MTPDmessages_messages &data) {
 			return data.vmessages().v.size();
@@ -1006,47 +1140,87 @@ void ApiWrap::requestMessagesCount(int localSplitIndex) {
 			_settings->singlePeerFrom);
 		if (skipSplit) {
 			// No messages from the requested range, skip this split.
-			messagesCountLoaded(localSplitIndex, 0);
+			messagesCountLoaded(process, localSplitIndex, 0);
 			return;
 		}
-		checkFirstMessageDate(localSplitIndex, count);
+		checkFirstMessageDate(process, localSplitIndex, count);
 	});
 }
 
-void ApiWrap::checkFirstMessageDate(int localSplitIndex, int count) {
-	Expects(_chatProcess != nullptr);
-	Expects(localSplitIndex < _chatProcess->info.splits.size());
+void ApiWrap::checkFirstMessageDate(
+		not_null<ChatProcess*> process,
+		int localSplitIndex,
+		int count) {
+	Expects(localSplitIndex < process->info.splits.size());
 
 	if (_settings->singlePeerTill <= 0) {
-		messagesCountLoaded(localSplitIndex, count);
+		messagesCountLoaded(process, localSplitIndex, count);
 		return;
 	}
 
 	// Request first message in this split to check if its' date < till.
 	requestChatMessages(
-		_chatProcess->info.splits[localSplitIndex],
+		process,
+		process->info.splits[localSplitIndex],
 		1, // offset_id
 		-1, // add_offset
 		1, // limit
 		[=](const MTPmessages_Messages &result) {
-		Expects(_chatProcess != nullptr);
-
 		const auto skipSplit = !Data::SingleMessageBefore(
 			result,
 			_settings->singlePeerTill);
-		messagesCountLoaded(localSplitIndex, skipSplit ? 0 : count);
+		messagesCountLoaded(process, localSplitIndex, skipSplit ? 0 : count);
 	});
 }
 
-void ApiWrap::messagesCountLoaded(int localSplitIndex, int count) {
-	Expects(_chatProcess != nullptr);
-	Expects(localSplitIndex < _chatProcess->info.splits.size());
+void ApiWrap::messagesCountLoaded(
+		not_null<ChatProcess*> process,
+		int localSplitIndex,
+		int count) {
+	Expects(localSplitIndex < process->info.splits.size());
+
+	process->info.messagesCountPerSplit[localSplitIndex] = count;
+	if (localSplitIndex + 1 < process->info.splits.size()) {
+		requestMessagesCount(process, localSplitIndex + 1);
+		return;
+	}
+	process->countsLoaded = true;
+	if (process->background) {
+		requestMessagesSlice(process);
+		loadNextMessagesSlice(process);
+	} else {
+		startMessages(process);
+	}
+}
+
+void ApiWrap::startMessages(not_null<ChatProcess*> process) {
+	Expects(!process->background);
+	Expects(process->countsLoaded);
+
+	if (!process->start(process->info)) {
+		return;
+	}
 
-	_chatProcess->info.messagesCountPerSplit[localSplitIndex] = count;
-	if (localSplitIndex + 1 < _chatProcess->info.splits.size()) {
-		requestMessagesCount(localSplitIndex + 1);
-	} else if (_chatProcess->start(_chatProcess->info)) {
-		requestMessagesSlice();
+	// Pass the slices loaded while the dialog was waiting for its turn.
+	while (!process->ready.empty()) {
+		auto slice = std::move(process->ready.front());
+		process->ready.pop_front();
+		if (!process->handleSlice(std::move(slice))) {
+			return;
+		}
+	}
+	if (process->finished) {
+		finishMessages(process);
+	} else if (!process->slice) {
+		if (_messagesPaused) {
+			// Continue in resumeMessages().
+			process->waitingForSlice = false;
+			process->paused = true;
+			return;
+		}
+		process->waitingForSlice = true;
+		requestMessagesSlice(process);
+		loadNextMessagesSlice(process);
 	}
 }
 
@@ -1370,61 +1544,88 @@ void ApiWrap::appendChatsSlice(
 	}
 }
 
-void ApiWrap::requestMessagesSlice() {
-	Expects(_chatProcess != nullptr);
-
-	const auto count = _chatProcess->info.messagesCountPerSplit[
-		_chatProcess->localSplitIndex];
-	if (!count) {
-		loadMessagesFiles({});
+void ApiWrap::requestMessagesSlice(not_null<ChatProcess*> process) {
+	const auto &counts = process->info.messagesCountPerSplit;
+	const auto prefetchLimit = _settings->slicesPrefetch
+		+ (process->waitingForSlice ? 1 : 0);
+	if (process->requesting
+		|| process->prefetched.size() >= prefetchLimit) {
+		return;
+	}
+	while (process->requestSplitIndex < counts.size()
+		&& !counts[process->requestSplitIndex]) {
+		++process->requestSplitIndex;
+	}
+	if (process->requestSplitIndex == counts.size()) {
 		return;
 	}
+	const auto localSplitIndex = process->requestSplitIndex;
+	process->requesting = true;
 	requestChatMessages(
-		_chatProcess->info.splits[_chatProcess->localSplitIndex],
-		_chatProcess->largestIdPlusOne,
+		process,
+		process->info.splits[localSplitIndex],
+		process->largestIdPlusOne,
 		-kMessagesSliceLimit,
 		kMessagesSliceLimit,
 		[=](const MTPmessages_Messages &result) {
-		Expects(_chatProcess != nullptr);
-
+		process->requesting = false;
 		result.match([&](const MTPDmessages_messagesNotModified &data) {
 			error("Unexpected messagesNotModified received.");
 		}, [&](const auto &data) {
-			if constexpr (MTPDmessages_messages::Is<decltype(data)>()) {
-				_chatProcess->lastSlice = true;
-			}
-			loadMessagesFiles(Data::ParseMessagesSlice(
-				_chatProcess->context,
-				data.vmessages(),
-				data.vusers(),
-				data.vchats(),
-				_chatProcess->info.relativePath));
+			messagesSliceReceived(
+				process,
+				localSplitIndex,
+				Data::ParseMessagesSlice(
+					process->context,
+					data.vmessages(),
+					data.vusers(),
+					data.vchats(),
+					process->info.relativePath),
+				MTPDmessages_messages::Is<decltype(data)>());
 		});
 	});
 }
 
+void ApiWrap::messagesSliceReceived(
+		not_null<ChatProcess*> process,
+		int localSplitIndex,
+		Data::MessagesSlice &&slice,
+		bool lastSlice) {
+	if (slice.list.empty()) {
+		lastSlice = true;
+	} else {
+		process->largestIdPlusOne = slice.list.back().id + 1;
+		process->prefetched.push_back({
+			std::move(slice),
+			localSplitIndex });
+	}
+	if (lastSlice) {
+		++process->requestSplitIndex;
+		process->largestIdPlusOne = 1;
+	}
+	requestMessagesSlice(process);
+	loadNextMessagesSlice(process);
+}
+
 void ApiWrap::requestChatMessages(
+		not_null<ChatProcess*> process,
 		int splitIndex,
 		int offsetId,
 		int addOffset,
 		int limit,
 		FnMut<void(MTPmessages_Messages&&)> done) {
-	Expects(_chatProcess != nullptr);
-
-	_chatProcess->requestDone = std::move(done);
+	process->requestDone = std::move(done);
 	const auto doneHandler = [=](MTPmessages_Messages &&result) {
-		Expects(_chatProcess != nullptr);
-
-		base::take(_chatProcess->requestDone)(std::move(result));
+		base::take(process->requestDone)(std::move(result));
 	};
 	const auto splitsCount = int(_splits.size());
 	const auto realPeerInput = (splitIndex >= 0)
-		? _chatProcess->info.input
-		: _chatProcess->info.migratedFromInput;
+		? process->info.input
+		: process->info.migratedFromInput;
 	const auto realSplitIndex = (splitIndex >= 0)
 		? splitIndex
 		: (splitsCount + splitIndex);
-	if (_chatProcess->info.onlyMyMessages) {
+	if (process->info.onlyMyMessages) {
 		splitRequest(realSplitIndex, MTPmessages_Search(
 			MTP_flags(MTPmessages_Search::Flag::f_from_id),
 			realPeerInput,
@@ -1452,21 +1653,20 @@ void ApiWrap::requestChatMessages(
 			MTP_int(0), // min_id
 			MTP_int(0)  // hash
 		)).fail([=](const RPCError &error) {
-			Expects(_chatProcess != nullptr);
-
 			if (error.type() == qstr("CHANNEL_PRIVATE")) {
 				if (realPeerInput.type() == mtpc_inputPeerChannel
-					&& !_chatProcess->info.onlyMyMessages) {
+					&& !process->info.onlyMyMessages) {
 
 					// Perhaps we just left / were kicked from channel.
 					// Just switch to only my messages.
-					_chatProcess->info.onlyMyMessages = true;
+					process->info.onlyMyMessages = true;
 					requestChatMessages(
+						process,
 						splitIndex,
 						offsetId,
 						addOffset,
 						limit,
-						base::take(_chatProcess->requestDone));
+						base::take(process->requestDone));
 					return true;
 				}
 			}
@@ -1475,165 +1675,177 @@ void ApiWrap::requestChatMessages(
 	}
 }
 
-void ApiWrap::loadMessagesFiles(Data::MessagesSlice &&slice) {
-	Expects(_chatProcess != nullptr);
-	Expects(!_chatProcess->slice.has_value());
-
-	if (slice.list.empty()) {
-		_chatProcess->lastSlice = true;
+void ApiWrap::loadNextMessagesSlice(not_null<ChatProcess*> process) {
+	if (!process->waitingForSlice) {
+		return;
+	} else if (!process->prefetched.empty()) {
+		auto next = std::move(process->prefetched.front());
+		process->prefetched.pop_front();
+		process->waitingForSlice = false;
+		process->localSplitIndex = next.localSplitIndex;
+		loadMessagesFiles(process, std::move(next.slice));
+	} else if (!process->requesting
+		&& (process->requestSplitIndex
+			== process->info.splits.size())) {
+		finishMessages(process);
 	}
-	_chatProcess->slice = std::move(slice);
-	_chatProcess->fileIndex = 0;
-
-	loadNextMessageFile();
 }
 
-Data::Message *ApiWrap::currentFileMessage() const {
-	Expects(_chatProcess != nullptr);
-	Expects(_chatProcess->slice.has_value());
+void ApiWrap::loadMessagesFiles(
+		not_null<ChatProcess*> process,
+		Data::MessagesSlice &&slice) {
+	Expects(!process->slice.has_value());
 
-	return &_chatProcess->slice->list[_chatProcess->fileIndex];
+	process->slice = std::move(slice);
+	process->fileIndex = 0;
+
+	loadNextMessageFile(process);
 }
 
-Data::FileOrigin ApiWrap::currentFileMessageOrigin() const {
-	Expects(_chatProcess != nullptr);
-	Expects(_chatProcess->slice.has_value());
+Data::FileOrigin ApiWrap::messageFileOrigin(
+		not_null<ChatProcess*> process,
+		int index) const {
+	Expects(process->slice.has_value());
 
-	const auto splitIndex = _chatProcess->info.splits[
-		_chatProcess->localSplitIndex];
+	const auto splitIndex = process->info.splits[
+		process->localSplitIndex];
 	auto result = Data::FileOrigin();
-	result.messageId = currentFileMessage()->id;
+	result.messageId = process->slice->list[index].id;
 	result.split = (splitIndex >= 0)
 		? splitIndex
 		: (int(_splits.size()) + splitIndex);
 	result.peer = (splitIndex >= 0)
-		? _chatProcess->info.input
-		: _chatProcess->info.migratedFromInput;
+		? process->info.input
+		: process->info.migratedFromInput;
 	return result;
 }
 
-void ApiWrap::loadNextMessageFile() {
-	Expects(_chatProcess != nullptr);
-	Expects(_chatProcess->slice.has_value());
+void ApiWrap::loadNextMessageFile(not_null<ChatProcess*> process) {
+	Expects(process->slice.has_value());
 
-	for (auto &list = _chatProcess->slice->list
-		; _chatProcess->fileIndex < list.size()
-		; ++_chatProcess->fileIndex) {
-		const auto &message = list[_chatProcess->fileIndex];
-		if (Data::SkipMessageByDate(message, *_settings)) {
+	const auto &list = process->slice->list;
+	while (process->fileIndex < list.size()
+		&& (process->filesLoading.size()
+			< _settings->filesInFlight)) {
+		const auto index = process->fileIndex++;
+		if (Data::SkipMessageByDate(list[index], *_settings)) {
 			continue;
 		}
-		const auto fileProgress = [=](FileProgress value) {
-			return loadMessageFileProgress(value);
-		};
-		const auto ready = processFileLoad(
-			list[_chatProcess->fileIndex].file(),
-			currentFileMessageOrigin(),
-			fileProgress,
-			[=](const QString &path) { loadMessageFileDone(path); },
-			currentFileMessage());
-		if (!ready) {
-			return;
-		}
-		const auto thumbProgress = [=](FileProgress value) {
-			return loadMessageThumbProgress(value);
-		};
-		const auto thumbReady = processFileLoad(
-			list[_chatProcess->fileIndex].thumb().file,
-			currentFileMessageOrigin(),
-			thumbProgress,
-			[=](const QString &path) { loadMessageThumbDone(path); },
-			currentFileMessage());
-		if (!thumbReady) {
-			return;
-		}
+		loadMessageFile(process, index, false);
+		loadMessageFile(process, index, true);
+	}
+	if (process->fileIndex == list.size()
+		&& process->filesLoading.empty()) {
+		finishMessagesSlice(process);
 	}
-	finishMessagesSlice();
 }
 
-void ApiWrap::finishMessagesSlice() {
-	Expects(_chatProcess != nullptr);
-	Expects(_chatProcess->slice.has_value());
+void ApiWrap::loadMessageFile(
+		not_null<ChatProcess*> process,
+		int index,
+		bool thumb) {
+	Expects(process->slice.has_value());
 
-	auto slice = *base::take(_chatProcess->slice);
+	auto &message = process->slice->list[index];
+	auto &file = thumb ? message.thumb().file : message.file();
+	const auto key = MessageFileKey(index, thumb);
+	process->filesLoading.emplace(key, FileProgress());
+	const auto progress = [=](FileProgress value) {
+		return loadMessageFileProgress(process, key, value);
+	};
+	const auto ready = processFileLoad(
+		file,
+		messageFileOrigin(process, index),
+		progress,
+		[=](const QString &path) { loadMessageFileDone(process, key, path); },
+		&message);
+	if (ready) {
+		process->filesLoading.remove(key);
+	}
+}
+
+void ApiWrap::finishMessagesSlice(not_null<ChatProcess*> process) {
+	Expects(process->slice.has_value());
+
+	auto slice = *base::take(process->slice);
 	if (!slice.list.empty()) {
-		_chatProcess->largestIdPlusOne = slice.list.back().id + 1;
-		const auto splitIndex = _chatProcess->info.splits[
-			_chatProcess->localSplitIndex];
+		const auto splitIndex = process->info.splits[
+			process->localSplitIndex];
 		if (splitIndex < 0) {
 			slice = AdjustMigrateMessageIds(std::move(slice));
 		}
-		if (!_chatProcess->handleSlice(std::move(slice))) {
+		if (process->background) {
+			process->ready.push_back(std::move(slice));
+		} else if (!process->handleSlice(std::move(slice))) {
 			return;
 		}
 	}
-	if (_chatProcess->lastSlice
-		&& (++_chatProcess->localSplitIndex
-			< _chatProcess->info.splits.size())) {
-		_chatProcess->lastSlice = false;
-		_chatProcess->largestIdPlusOne = 1;
-	}
-	if (!_chatProcess->lastSlice) {
-		requestMessagesSlice();
-	} else {
-		finishMessages();
+	if (process->background
+		&& process->ready.size() > _settings->slicesPrefetch) {
+		// Wait until this dialog is requested.
+		return;
+	} else if (!process->background && _messagesPaused) {
+		// Continue in resumeMessages().
+		process->paused = true;
+		return;
 	}
+	process->waitingForSlice = true;
+	requestMessagesSlice(process);
+	loadNextMessagesSlice(process);
 }
 
-bool ApiWrap::loadMessageFileProgress(FileProgress progress) {
-	Expects(_fileProcess != nullptr);
-	Expects(_chatProcess != nullptr);
-	Expects(_chatProcess->slice.has_value());
-	Expects((_chatProcess->fileIndex >= 0)
-		&& (_chatProcess->fileIndex < _chatProcess->slice->list.size()));
-
-	return _chatProcess->fileProgress(DownloadProgress{
-		_fileProcess->relativePath,
-		_chatProcess->fileIndex,
-		progress.ready,
-		progress.total });
-}
-
-void ApiWrap::loadMessageFileDone(const QString &relativePath) {
-	Expects(_chatProcess != nullptr);
-	Expects(_chatProcess->slice.has_value());
-	Expects((_chatProcess->fileIndex >= 0)
-		&& (_chatProcess->fileIndex < _chatProcess->slice->list.size()));
-
-	const auto index = _chatProcess->fileIndex;
-	auto &file = _chatProcess->slice->list[index].file();
-	file.relativePath = relativePath;
-	if (relativePath.isEmpty()) {
-		file.skipReason = Data::File::SkipReason::Unavailable;
+bool ApiWrap::loadMessageFileProgress(
+		not_null<ChatProcess*> process,
+		int key,
+		FileProgress progress) {
+	const auto i = process->filesLoading.find(key);
+	if (i == end(process->filesLoading)) {
+		return true;
+	}
+	i->second = std::move(progress);
+	if (process->background) {
+		return true;
 	}
-	loadNextMessageFile();
-}
 
-bool ApiWrap::loadMessageThumbProgress(FileProgress progress) {
-	return loadMessageFileProgress(progress);
+	// Files of all the messages before the earliest loading one are ready.
+	const auto &[earliest, shown] = *process->filesLoading.begin();
+	return process->fileProgress(DownloadProgress{
+		shown.path,
+		MessageFileIndex(earliest),
+		shown.ready,
+		shown.total });
 }
 
-void ApiWrap::loadMessageThumbDone(const QString &relativePath) {
-	Expects(_chatProcess != nullptr);
-	Expects(_chatProcess->slice.has_value());
-	Expects((_chatProcess->fileIndex >= 0)
-		&& (_chatProcess->fileIndex < _chatProcess->slice->list.size()));
+void ApiWrap::loadMessageFileDone(
+		not_null<ChatProcess*> process,
+		int key,
+		const QString &relativePath) {
+	Expects(process->slice.has_value());
 
-	const auto index = _chatProcess->fileIndex;
-	auto &file = _chatProcess->slice->list[index].thumb().file;
+	const auto index = MessageFileIndex(key);
+	Assert(index >= 0 && index < process->slice->list.size());
+
+	auto &message = process->slice->list[index];
+	auto &file = MessageFileIsThumb(key)
+		? message.thumb().file
+		: message.file();
 	file.relativePath = relativePath;
 	if (relativePath.isEmpty()) {
 		file.skipReason = Data::File::SkipReason::Unavailable;
 	}
-	loadNextMessageFile();
+	process->filesLoading.remove(key);
+	loadNextMessageFile(process);
 }
 
-void ApiWrap::finishMessages() {
-	Expects(_chatProcess != nullptr);
-	Expects(!_chatProcess->slice.has_value());
+void ApiWrap::finishMessages(not_null<ChatProcess*> process) {
+	Expects(!process->slice.has_value());
 
-	const auto process = base::take(_chatProcess);
-	process->done();
+	if (process->background) {
+		process->finished = true;
+		return;
+	}
+	Assert(_chatProcess.get() == process);
+	base::take(_chatProcess)->done();
 }
 
 bool ApiWrap::processFileLoad(
@@ -1685,6 +1897,11 @@ bool ApiWrap::processFileLoad(
 		// Don't load thumbs for large files that we skip.
 		file.skipReason = SkipReason::FileSize;
 		return true;
+	} else if (const auto path = findCheckpointFile(file.location)) {
+		// Written by one of the previous exports to the same folder.
+		file.relativePath = *path;
+		_fileCache->save(file.location, file.relativePath);
+		return true;
 	}
 	loadFile(file, origin, std::move(progress), std::move(done));
 	return false;
@@ -1702,9 +1919,16 @@ bool ApiWrap::writePreloadedFile(
 		return true;
 	} else if (!file.content.isEmpty()) {
 		const auto process = prepareFileProcess(file, origin);
-		if (const auto result = process->file.writeBlock(file.content)) {
+		const auto result = [&] {
+			const auto result = process->file.writeBlock(file.content);
+			return result ? process->file.flush() : result;
+		}();
+		if (result) {
 			file.relativePath = process->relativePath;
-			_fileCache->save(file.location, file.relativePath);
+			saveLoadedFile(
+				file.location,
+				file.relativePath,
+				process->file.size());
 		} else {
 			ioError(result);
 		}
@@ -1713,30 +1937,75 @@ bool ApiWrap::writePreloadedFile(
 	return false;
 }
 
+std::optional<QString> ApiWrap::findCheckpointFile(
+		const Data::FileLocation &location) const {
+	if (!_checkpoint) {
+		return std::nullopt;
+	} else if (const auto key = CheckpointFileKey(location)) {
+		return _checkpoint->findFile(*key);
+	}
+	return std::nullopt;
+}
+
+void ApiWrap::saveLoadedFile(
+		const Data::FileLocation &location,
+		const QString &relativePath,
+		int64 size) {
+	_fileCache->save(location, relativePath);
+	if (!_checkpoint) {
+		return;
+	} else if (const auto key = CheckpointFileKey(location)) {
+		const auto result = _checkpoint->saveFile(*key, relativePath, size);
+		if (!result) {
+			ioError(result);
+		}
+	}
+}
+
 void ApiWrap::loadFile(
 		const Data::File &file,
 		const Data::FileOrigin &origin,
 		Fn<bool(FileProgress)> progress,
 		FnMut<void(QString)> done) {
-	Expects(_fileProcess == nullptr);
 	Expects(file.location.dcId != 0
 		|| file.location.data.type() == mtpc_inputTakeoutFileLocation);
 
-	_fileProcess = prepareFileProcess(file, origin);
-	_fileProcess->progress = std::move(progress);
-	_fileProcess->done = std::move(done);
+	// The same media can be attached to several messages of a slice,
+	// write it once and give the same path to all of them.
+	const auto key = ComputeLocationKey(file.location);
+	for (const auto &[id, process] : _fileProcesses) {
+		if (ComputeLocationKey(process->location) == key) {
+			process->sameFileDone.push_back(std::move(done));
+			if (progress) {
+				progress(FileProgress{
+					process->file.size(),
+					process->size,
+					process->relativePath });
+			}
+			return;
+		}
+	}
+
+	auto process = prepareFileProcess(file, origin);
+	process->id = ++_fileProcessIdLast;
+	process->progress = std::move(progress);
+	process->done = std::move(done);
+	_fileProcessPaths.emplace(process->relativePath);
 
-	if (_fileProcess->progress) {
+	const auto raw = process.get();
+	_fileProcesses.emplace(raw->id, std::move(process));
+	if (raw->progress) {
 		const auto progress = FileProgress{
-			_fileProcess->file.size(),
-			_fileProcess->size
+			raw->file.size(),
+			raw->size,
+			raw->relativePath
 		};
-		if (!_fileProcess->progress(progress)) {
+		if (!raw->progress(progress)) {
 			return;
 		}
 	}
 
-	loadFilePart();
+	loadFilePart(raw->id);
 }
 
 auto ApiWrap::prepareFileProcess(
@@ -1747,7 +2016,10 @@ auto ApiWrap::prepareFileProcess(
 
 	const auto relativePath = Output::File::PrepareRelativePath(
 		_settings->path,
-		file.suggestedPath);
+		(_settings->media.sharedFolder
+			? SharedMediaPath(file)
+			: file.suggestedPath),
+		_fileProcessPaths);
 	auto result = std::make_unique<FileProcess>(
 		_settings->path + relativePath,
 		_stats);
@@ -1758,40 +2030,46 @@ auto ApiWrap::prepareFileProcess(
 	return result;
 }
 
-void ApiWrap::loadFilePart() {
-	if (!_fileProcess
-		|| _fileProcess->requests.size() >= kFileRequestsCount
-		|| (_fileProcess->size > 0
-			&& _fileProcess->offset >= _fileProcess->size)) {
+ApiWrap::FileProcess *ApiWrap::fileProcess(uint64 processId) const {
+	const auto i = _fileProcesses.find(processId);
+	return (i != end(_fileProcesses)) ? i->second.get() : nullptr;
+}
+
+void ApiWrap::loadFilePart(uint64 processId) {
+	const auto process = fileProcess(processId);
+	if (!process) {
 		return;
 	}
+	while (process->requests.size() < _settings->filePartsInFlight
+		&& (process->size <= 0 || process->offset < process->size)) {
+		const auto offset = process->offset;
+		process->requests.push_back({ offset });
+		fileRequest(
+			processId,
+			process->location,
+			offset
+		).done([=](const MTPupload_File &result) {
+			filePartDone(processId, offset, result);
+		}).send();
+		process->offset += kFileChunkSize;
 
-	const auto offset = _fileProcess->offset;
-	_fileProcess->requests.push_back({ offset });
-	fileRequest(
-		_fileProcess->location,
-		_fileProcess->offset
-	).done([=](const MTPupload_File &result) {
-		filePartDone(offset, result);
-	}).send();
-	_fileProcess->offset += kFileChunkSize;
-
-	if (_fileProcess->size > 0
-		&& _fileProcess->requests.size() < kFileRequestsCount) {
-		//const auto runner = _runner;
-		//crl::on_main([=] {
-		//	QTimer::singleShot(kFileNextRequestDelay, [=] {
-		//		runner([=] {
-		//			loadFilePart();
-		//		});
-		//	});
-		//});
+		// Without the known size we request parts one by one
+		// until an empty or a partial one is received.
+		if (process->size <= 0) {
+			break;
+		}
 	}
 }
 
-void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
-	Expects(_fileProcess != nullptr);
-	Expects(!_fileProcess->requests.empty());
+void ApiWrap::filePartDone(
+		uint64 processId,
+		int offset,
+		const MTPupload_File &result) {
+	const auto process = fileProcess(processId);
+	if (!process) {
+		return;
+	}
+	Assert(!process->requests.empty());
 
 	if (result.type() == mtpc_upload_fileCdnRedirect) {
 		error("Cdn redirect is not supported.");
@@ -1799,18 +2077,18 @@ void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 	}
 	const auto &data = result.c_upload_file();
 	if (data.vbytes().v.isEmpty()) {
-		if (_fileProcess->size > 0) {
+		if (process->size > 0) {
 			error("Empty bytes received in file part.");
 			return;
 		}
-		const auto result = _fileProcess->file.writeBlock({});
+		const auto result = process->file.writeBlock({});
 		if (!result) {
 			ioError(result);
 			return;
 		}
 	} else {
 		using Request = FileProcess::Request;
-		auto &requests = _fileProcess->requests;
+		auto &requests = process->requests;
 		const auto i = ranges::find(
 			requests,
 			offset,
@@ -1819,7 +2097,7 @@ void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 
 		i->bytes = data.vbytes().v;
 
-		auto &file = _fileProcess->file;
+		auto &file = process->file;
 		while (!requests.empty() && !requests.front().bytes.isEmpty()) {
 			const auto &bytes = requests.front().bytes;
 			if (const auto result = file.writeBlock(bytes); !result) {
@@ -1829,30 +2107,56 @@ void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 			requests.pop_front();
 		}
 
-		if (_fileProcess->progress) {
-			_fileProcess->progress(FileProgress{
+		if (process->progress) {
+			process->progress(FileProgress{
 				file.size(),
-				_fileProcess->size });
+				process->size,
+				process->relativePath });
 		}
 
 		if (!requests.empty()
-			|| !_fileProcess->size
-			|| _fileProcess->size > _fileProcess->offset) {
-			loadFilePart();
+			|| !process->size
+			|| process->size > process->offset) {
+			loadFilePart(processId);
 			return;
 		}
 	}
 
-	auto process = base::take(_fileProcess);
-	const auto relativePath = process->relativePath;
-	_fileCache->save(process->location, relativePath);
-	process->done(process->relativePath);
+	if (const auto result = process->file.flush(); !result) {
+		ioError(result);
+		return;
+	}
+	saveLoadedFile(
+		process->location,
+		process->relativePath,
+		process->file.size());
+	finishFileProcess(processId, process->relativePath);
 }
 
-void ApiWrap::filePartRefreshReference(int offset) {
-	Expects(_fileProcess != nullptr);
+void ApiWrap::finishFileProcess(
+		uint64 processId,
+		const QString &relativePath) {
+	const auto i = _fileProcesses.find(processId);
+	Assert(i != end(_fileProcesses));
 
-	const auto &origin = _fileProcess->origin;
+	auto process = std::move(i->second);
+	_fileProcesses.erase(i);
+	_fileProcessPaths.remove(process->relativePath);
+
+	// Callbacks may start new file loads, so call them at the very end.
+	process->done(relativePath);
+	for (auto &done : process->sameFileDone) {
+		done(relativePath);
+	}
+}
+
+void ApiWrap::filePartRefreshReference(uint64 processId, int offset) {
+	const auto process = fileProcess(processId);
+	if (!process) {
+		return;
+	}
+
+	const auto &origin = process->origin;
 	if (!origin.messageId) {
 		error("FILE_REFERENCE error for non-message file.");
 		return;
@@ -1873,10 +2177,10 @@ void ApiWrap::filePartRefreshReference(int offset) {
 				1,
 				MTP_inputMessageID(MTP_int(origin.messageId)))
 		)).fail([=](const RPCError &error) {
-			filePartUnavailable();
+			filePartUnavailable(processId);
 			return true;
 		}).done([=](const MTPmessages_Messages &result) {
-			filePartExtractReference(offset, result);
+			filePartExtractReference(processId, offset, result);
 		}).send();
 	} else {
 		splitRequest(origin.split, MTPmessages_GetMessages(
@@ -1884,18 +2188,22 @@ void ApiWrap::filePartRefreshReference(int offset) {
 				1,
 				MTP_inputMessageID(MTP_int(origin.messageId)))
 		)).fail([=](const RPCError &error) {
-			filePartUnavailable();
+			filePartUnavailable(processId);
 			return true;
 		}).done([=](const MTPmessages_Messages &result) {
-			filePartExtractReference(offset, result);
+			filePartExtractReference(processId, offset, result);
 		}).send();
 	}
 }
 
 void ApiWrap::filePartExtractReference(
+		uint64 processId,
 		int offset,
 		const MTPmessages_Messages &result) {
-	Expects(_fileProcess != nullptr);
+	const auto process = fileProcess(processId);
+	if (!process) {
+		return;
+	}
 
 	result.match([&](const MTPDmessages_messagesNotModified &data) {
 		error("Unexpected messagesNotModified received.");
@@ -1909,37 +2217,39 @@ void ApiWrap::filePartExtractReference(
 			data.vmessages(),
 			data.vusers(),
 			data.vchats(),
-			_chatProcess->info.relativePath);
+			QString()); // Only the file locations are used here.
 		for (const auto &message : messages.list) {
-			if (message.id == _fileProcess->origin.messageId) {
+			if (message.id == process->origin.messageId) {
 				const auto refresh1 = Data::RefreshFileReference(
-					_fileProcess->location,
+					process->location,
 					message.file().location);
 				const auto refresh2 = Data::RefreshFileReference(
-					_fileProcess->location,
+					process->location,
 					message.thumb().file.location);
 				if (refresh1 || refresh2) {
 					fileRequest(
-						_fileProcess->location,
+						processId,
+						process->location,
 						offset
 					).done([=](const MTPupload_File &result) {
-						filePartDone(offset, result);
+						filePartDone(processId, offset, result);
 					}).send();
 					return;
 				}
 			}
 		}
-		filePartUnavailable();
+		filePartUnavailable(processId);
 	});
 }
 
-void ApiWrap::filePartUnavailable() {
-	Expects(_fileProcess != nullptr);
-	Expects(!_fileProcess->requests.empty());
+void ApiWrap::filePartUnavailable(uint64 processId) {
+	if (!fileProcess(processId)) {
+		return;
+	}
 
 	LOG(("Export Error: File unavailable."));
 
-	base::take(_fileProcess)->done(QString());
+	finishFileProcess(processId, QString());
 }
 
 void ApiWrap::error(RPCError &&error) {
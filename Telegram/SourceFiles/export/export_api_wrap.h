@@ -29,6 +29,7 @@ struct FileOrigin;
 namespace Output {
 struct Result;
 class Stats;
+class Checkpoint;
 } // namespace Output
 
 struct Settings;
@@ -47,6 +48,7 @@ public:
 	void startExport(
 		const Settings &settings,
 		Output::Stats *stats,
+		Output::Checkpoint *checkpoint,
 		FnMut<void(StartInfo)> done);
 
 	void requestDialogsList(
@@ -82,6 +84,15 @@ public:
 		Fn<bool(Data::MessagesSlice&&)> slice,
 		FnMut<void()> done);
 
+	// Starts loading a dialog that will be requested later, its slices
+	// are kept until requestMessages() is called with the same dialog.
+	void prefetchMessages(const Data::DialogInfo &info);
+
+	// While paused, the loaded slices of the dialog being written are not
+	// passed to the callback and the next ones are not loaded.
+	void pauseMessages();
+	void resumeMessages();
+
 	void finishExport(FnMut<void()> done);
 	void cancelExportFast();
 
@@ -143,27 +154,56 @@ private:
 		std::vector<Data::DialogInfo> &&from,
 		int splitIndex);
 
-	void requestMessagesCount(int localSplitIndex);
-	void checkFirstMessageDate(int localSplitIndex, int count);
-	void messagesCountLoaded(int localSplitIndex, int count);
-	void requestMessagesSlice();
+	[[nodiscard]] std::unique_ptr<ChatProcess> createChatProcess(
+		const Data::DialogInfo &info) const;
+	void requestMessagesCount(
+		not_null<ChatProcess*> process,
+		int localSplitIndex);
+	void checkFirstMessageDate(
+		not_null<ChatProcess*> process,
+		int localSplitIndex,
+		int count);
+	void messagesCountLoaded(
+		not_null<ChatProcess*> process,
+		int localSplitIndex,
+		int count);
+	void startMessages(not_null<ChatProcess*> process);
+	void requestMessagesSlice(not_null<ChatProcess*> process);
+	void messagesSliceReceived(
+		not_null<ChatProcess*> process,
+		int localSplitIndex,
+		Data::MessagesSlice &&slice,
+		bool lastSlice);
 	void requestChatMessages(
+		not_null<ChatProcess*> process,
 		int splitIndex,
 		int offsetId,
 		int addOffset,
 		int limit,
 		FnMut<void(MTPmessages_Messages&&)> done);
-	void loadMessagesFiles(Data::MessagesSlice &&slice);
-	void loadNextMessageFile();
-	bool loadMessageFileProgress(FileProgress value);
-	void loadMessageFileDone(const QString &relativePath);
-	bool loadMessageThumbProgress(FileProgress value);
-	void loadMessageThumbDone(const QString &relativePath);
-	void finishMessagesSlice();
-	void finishMessages();
-
-	[[nodiscard]] Data::Message *currentFileMessage() const;
-	[[nodiscard]] Data::FileOrigin currentFileMessageOrigin() const;
+	void loadNextMessagesSlice(not_null<ChatProcess*> process);
+	void loadMessagesFiles(
+		not_null<ChatProcess*> process,
+		Data::MessagesSlice &&slice);
+	void loadNextMessageFile(not_null<ChatProcess*> process);
+	void loadMessageFile(
+		not_null<ChatProcess*> process,
+		int index,
+		bool thumb);
+	bool loadMessageFileProgress(
+		not_null<ChatProcess*> process,
+		int key,
+		FileProgress value);
+	void loadMessageFileDone(
+		not_null<ChatProcess*> process,
+		int key,
+		const QString &relativePath);
+	void finishMessagesSlice(not_null<ChatProcess*> process);
+	void finishMessages(not_null<ChatProcess*> process);
+
+	[[nodiscard]] Data::FileOrigin messageFileOrigin(
+		not_null<ChatProcess*> process,
+		int index) const;
 
 	bool processFileLoad(
 		Data::File &file,
@@ -177,18 +217,30 @@ private:
 	bool writePreloadedFile(
 		Data::File &file,
 		const Data::FileOrigin &origin);
+	[[nodiscard]] std::optional<QString> findCheckpointFile(
+		const Data::FileLocation &location) const;
+	void saveLoadedFile(
+		const Data::FileLocation &location,
+		const QString &relativePath,
+		int64 size);
 	void loadFile(
 		const Data::File &file,
 		const Data::FileOrigin &origin,
 		Fn<bool(FileProgress)> progress,
 		FnMut<void(QString)> done);
-	void loadFilePart();
-	void filePartDone(int offset, const MTPupload_File &result);
-	void filePartUnavailable();
-	void filePartRefreshReference(int offset);
+	[[nodiscard]] FileProcess *fileProcess(uint64 processId) const;
+	void loadFilePart(uint64 processId);
+	void filePartDone(
+		uint64 processId,
+		int offset,
+		const MTPupload_File &result);
+	void filePartUnavailable(uint64 processId);
+	void filePartRefreshReference(uint64 processId, int offset);
 	void filePartExtractReference(
+		uint64 processId,
 		int offset,
 		const MTPmessages_Messages &result);
+	void finishFileProcess(uint64 processId, const QString &relativePath);
 
 	template <typename Request>
 	class RequestBuilder;
@@ -200,6 +252,7 @@ private:
 	[[nodiscard]] auto splitRequest(int index, Request &&request);
 
 	[[nodiscard]] auto fileRequest(
+		uint64 processId,
 		const Data::FileLocation &location,
 		int offset);
 
@@ -211,6 +264,7 @@ private:
 	std::optional<uint64> _takeoutId;
 	std::optional<int32> _selfId;
 	Output::Stats *_stats = nullptr;
+	Output::Checkpoint *_checkpoint = nullptr;
 
 	std::unique_ptr<Settings> _settings;
 	MTPInputUser _user = MTP_inputUserSelf();
@@ -220,10 +274,14 @@ private:
 	std::unique_ptr<ContactsProcess> _contactsProcess;
 	std::unique_ptr<UserpicsProcess> _userpicsProcess;
 	std::unique_ptr<OtherDataProcess> _otherDataProcess;
-	std::unique_ptr<FileProcess> _fileProcess;
+	std::map<uint64, std::unique_ptr<FileProcess>> _fileProcesses;
+	base::flat_set<QString> _fileProcessPaths;
+	uint64 _fileProcessIdLast = 0;
 	std::unique_ptr<LeftChannelsProcess> _leftChannelsProcess;
 	std::unique_ptr<DialogsProcess> _dialogsProcess;
 	std::unique_ptr<ChatProcess> _chatProcess;
+	bool _messagesPaused = false;
+	std::vector<std::unique_ptr<ChatProcess>> _chatProcessesAhead;
 	QVector<MTPMessageRange> _splits;
 
 	rpl::event_stream<RPCError> _errors;
@@ -11,15 +11,22 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/export_settings.h"
 #include "export/data/export_data_types.h"
 #include "export/output/export_output_abstract.h"
+#include "export/output/export_output_checkpoint.h"
 #include "export/output/export_output_result.h"
 #include "export/output/export_output_stats.h"
 #include "mtproto/mtp_instance.h"
 
+#include <atomic>
+
 namespace Export {
 namespace {
 
 const auto kNullStateCallback = [](ProcessingState&) {};
 
+// Stop loading messages while that many slices wait to be written.
+constexpr auto kMaxQueuedSlices = 16;
+constexpr auto kResumeQueuedSlices = kMaxQueuedSlices / 2;
+
 Settings NormalizeSettings(const Settings &settings) {
 	if (!settings.onlySinglePeer()) {
 		return base::duplicate(settings);
@@ -37,6 +44,7 @@ public:
 		crl::weak_on_queue<ControllerObject> weak,
 		QPointer<MTP::Instance> mtproto,
 		const MTPInputPeer &peer);
+	~ControllerObject();
 
 	rpl::producer<State> state() const;
 
@@ -78,6 +86,12 @@ private:
 	void exportOtherData();
 	void exportDialogs();
 	void exportNextDialog();
+	void writeDialogSlice(Data::MessagesSlice &&slice);
+	void dialogSliceWritten();
+	void writeDialogEnd();
+	bool reuseFinishedDialogs();
+	bool writeFinishedDialog(const Data::DialogInfo &info);
+	bool saveDialogCheckpoint();
 
 	template <typename Callback = const decltype(kNullStateCallback) &>
 	ProcessingState prepareState(
@@ -99,12 +113,14 @@ private:
 
 	int substepsInStep(Step step) const;
 
+	crl::weak_on_queue<ControllerObject> _weak;
 	ApiWrap _api;
 	Settings _settings;
 	Environment _environment;
 
 	Data::DialogsInfo _dialogsInfo;
 	int _dialogIndex = -1;
+	base::flat_set<uint64> _reusedDialogs;
 
 	int _messagesWritten = 0;
 	int _messagesCount = 0;
@@ -117,6 +133,7 @@ private:
 	rpl::event_stream<State> _stateChanges;
 
 	Output::Stats _stats;
+	Output::Checkpoint _checkpoint;
 
 	std::vector<int> _substepsInStep;
 	int _substepsTotal = 0;
@@ -124,6 +141,14 @@ private:
 	mutable Step _lastProcessingStep = Step::Initializing;
 
 	std::unique_ptr<Output::AbstractWriter> _writer;
+
+	// Dialog slices are serialized here while the next ones are loaded.
+	crl::queue _writerQueue;
+	int _queuedSlices = 0;
+
+	// Set in the writer queue, the writes queued after it are skipped.
+	std::atomic<bool> _writerFailed = false;
+
 	std::vector<Step> _steps;
 	int _stepIndex = -1;
 
@@ -135,7 +160,8 @@ ControllerObject::ControllerObject(
 	crl::weak_on_queue<ControllerObject> weak,
 	QPointer<MTP::Instance> mtproto,
 	const MTPInputPeer &peer)
-: _api(mtproto, weak.runner())
+: _weak(weak)
+, _api(mtproto, weak.runner())
 , _state(PasswordCheckState{}) {
 	_api.errors(
 	) | rpl::start_with_next([=](RPCError &&error) {
@@ -155,6 +181,11 @@ ControllerObject::ControllerObject(
 	setState(std::move(state));
 }
 
+ControllerObject::~ControllerObject() {
+	// Wait for the slices already handed to the writer.
+	_writerQueue.sync([] {});
+}
+
 rpl::producer<State> ControllerObject::state() const {
 	return rpl::single(
 		_state
@@ -313,7 +344,8 @@ void ControllerObject::cancelExportFast() {
 
 void ControllerObject::exportNext() {
 	if (++_stepIndex >= _steps.size()) {
-		if (ioCatchError(_writer->finish())) {
+		if (ioCatchError(_writer->finish())
+			|| ioCatchError(_checkpoint.finish())) {
 			return;
 		}
 		_api.finishExport([=] {
@@ -338,9 +370,18 @@ void ControllerObject::exportNext() {
 
 void ControllerObject::initialize() {
 	setState(stateInitializing());
-	_api.startExport(_settings, &_stats, [=](ApiWrap::StartInfo info) {
-		initialized(info);
-	});
+	if (ioCatchError(_checkpoint.start(_settings))) {
+		return;
+	} else if (_checkpoint.filesCount() || _checkpoint.dialogsCount()) {
+		LOG(("Export Info: Checkpoint has %1 files and %2 chats."
+			).arg(_checkpoint.filesCount()
+			).arg(_checkpoint.dialogsCount()));
+	}
+	_api.startExport(
+		_settings,
+		&_stats,
+		&_checkpoint,
+		[=](ApiWrap::StartInfo info) { initialized(info); });
 }
 
 void ControllerObject::initialized(const ApiWrap::StartInfo &info) {
@@ -360,10 +401,50 @@ void ControllerObject::collectDialogsList() {
 		return true;
 	}, [=](Data::DialogsInfo &&result) {
 		_dialogsInfo = std::move(result);
-		exportNext();
+		if (reuseFinishedDialogs()) {
+			exportNext();
+		}
 	});
 }
 
+bool ControllerObject::reuseFinishedDialogs() {
+	auto reused = base::flat_set<uint64>();
+	auto paths = base::flat_set<QString>();
+	const auto enumerate = [&](auto &&callback) {
+		for (auto &dialog : _dialogsInfo.chats) {
+			callback(dialog);
+		}
+		for (auto &dialog : _dialogsInfo.left) {
+			callback(dialog);
+		}
+	};
+	if (_writer->canWriteFinishedDialog()) {
+		enumerate([&](Data::DialogInfo &dialog) {
+			const auto finished = _checkpoint.findDialog(dialog.peerId);
+			if (finished && finished->topMessageId == dialog.topMessageId) {
+				dialog.relativePath = finished->relativePath;
+				reused.emplace(dialog.peerId);
+				paths.emplace(dialog.relativePath);
+			}
+		});
+		enumerate([&](Data::DialogInfo &dialog) {
+			if (reused.contains(dialog.peerId)) {
+				return;
+			}
+			// Don't write other chats to the folders we reuse.
+			const auto base = dialog.relativePath.mid(
+				0,
+				dialog.relativePath.size() - 1);
+			for (auto i = 1; paths.contains(dialog.relativePath); ++i) {
+				dialog.relativePath = base + '_' + QString::number(i) + '/';
+			}
+			paths.emplace(dialog.relativePath);
+		});
+		_reusedDialogs = reused;
+	}
+	return !ioCatchError(_checkpoint.keepDialogs(reused));
+}
+
 void ControllerObject::exportPersonalInfo() {
 	setState(statePersonalInfo());
 	_api.requestPersonalInfo([=](Data::PersonalInfo &&result) {
@@ -440,8 +521,14 @@ void ControllerObject::exportDialogs() {
 }
 
 void ControllerObject::exportNextDialog() {
-	const auto index = ++_dialogIndex;
-	const auto info = _dialogsInfo.item(index);
+	auto index = ++_dialogIndex;
+	auto info = _dialogsInfo.item(index);
+	while (info && _reusedDialogs.contains(info->peerId)) {
+		if (!writeFinishedDialog(*info)) {
+			return;
+		}
+		info = _dialogsInfo.item(index = ++_dialogIndex);
+	}
 	if (info) {
 		_api.requestMessages(*info, [=](const Data::DialogInfo &info) {
 			if (ioCatchError(_writer->writeDialogStart(info))) {
@@ -457,18 +544,22 @@ void ControllerObject::exportNextDialog() {
 			setState(stateDialogs(progress));
 			return true;
 		}, [=](Data::MessagesSlice &&result) {
-			if (ioCatchError(_writer->writeDialogSlice(result))) {
+			if (v::is<OutputErrorState>(_state)) {
 				return false;
 			}
 			_messagesWritten += result.list.size();
 			setState(stateDialogs(DownloadProgress()));
+			writeDialogSlice(std::move(result));
 			return true;
 		}, [=] {
-			if (ioCatchError(_writer->writeDialogEnd())) {
-				return;
-			}
-			exportNextDialog();
+			writeDialogEnd();
 		});
+		for (auto ahead = 1; ahead < _settings.dialogsInFlight; ++ahead) {
+			const auto next = _dialogsInfo.item(index + ahead);
+			if (next && !_reusedDialogs.contains(next->peerId)) {
+				_api.prefetchMessages(*next);
+			}
+		}
 		return;
 	}
 	if (ioCatchError(_writer->writeDialogsEnd())) {
@@ -477,6 +568,75 @@ void ControllerObject::exportNextDialog() {
 	exportNext();
 }
 
+bool ControllerObject::writeFinishedDialog(const Data::DialogInfo &info) {
+	const auto finished = _checkpoint.findDialog(info.peerId);
+	Assert(finished != nullptr);
+
+	_messagesWritten = _messagesCount = finished->messagesCount;
+	setState(stateDialogs(DownloadProgress()));
+	return !ioCatchError(
+		_writer->writeFinishedDialog(info, finished->messagesCount));
+}
+
+void ControllerObject::writeDialogSlice(Data::MessagesSlice &&slice) {
+	if (++_queuedSlices == kMaxQueuedSlices) {
+		_api.pauseMessages();
+	}
+	const auto writer = _writer.get();
+	_writerQueue.async([=, slice = std::move(slice)] {
+		auto result = Output::Result::Success();
+		if (!_writerFailed) {
+			result = writer->writeDialogSlice(slice);
+			if (!result) {
+				_writerFailed = true;
+			}
+		}
+		_weak.with([=](ControllerObject &that) {
+			if (!that.ioCatchError(result)) {
+				that.dialogSliceWritten();
+			}
+		});
+	});
+}
+
+void ControllerObject::dialogSliceWritten() {
+	if (_queuedSlices-- == kResumeQueuedSlices + 1) {
+		_api.resumeMessages();
+	}
+}
+
+void ControllerObject::writeDialogEnd() {
+	// Continue with the next dialog when all its slices are written.
+	const auto writer = _writer.get();
+	_writerQueue.async([=] {
+		if (_writerFailed) {
+			return;
+		}
+		const auto result = writer->writeDialogEnd();
+		_weak.with([=](ControllerObject &that) {
+			if (!v::is<OutputErrorState>(that._state)
+				&& !that.ioCatchError(result)
+				&& that.saveDialogCheckpoint()) {
+				that.exportNextDialog();
+			}
+		});
+	});
+}
+
+bool ControllerObject::saveDialogCheckpoint() {
+	const auto info = _dialogsInfo.item(_dialogIndex);
+	Assert(info != nullptr);
+
+	if (!_writer->canWriteFinishedDialog()) {
+		return true;
+	}
+	return !ioCatchError(_checkpoint.saveDialog(info->peerId, {
+		info->topMessageId,
+		_messagesWritten,
+		info->relativePath,
+	}));
+}
+
 template <typename Callback>
 ProcessingState ControllerObject::prepareState(
 		Step step,
@@ -585,6 +745,10 @@ int ControllerObject::substepsInStep(Step step) const {
 }
 
 void ControllerObject::setFinishedState() {
+	LOG(("Export Info: Finished, %1 files, %2 bytes in %3 writes."
+		).arg(_stats.filesCount()
+		).arg(_stats.bytesCount()
+		).arg(_stats.writesCount()));
 	setState(FinishedState{
 		_writer->mainFilePath(),
 		_stats.filesCount(),
@@ -8,12 +8,14 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/export_manager.h"
 
 #include "export/export_controller.h"
+#include "export/export_runner.h"
 #include "export/view/export_view_panel_controller.h"
 #include "data/data_peer.h"
 #include "main/main_session.h"
 #include "main/main_account.h"
 #include "ui/layers/box_content.h"
 #include "base/unixtime.h"
+#include "app.h"
 
 namespace Export {
 
@@ -54,13 +56,53 @@ void Manager::start(
 	}, _controller->lifetime());
 }
 
+void Manager::startHeadless(
+		not_null<Main::Session*> session,
+		const QString &settingsPath) {
+	// Every way out must write the final line and quit, the caller waits.
+	const auto fail = [](const QString &reason) {
+		WriteRunnerError(reason);
+		App::quit();
+	};
+	if (inProgress()) {
+		LOG(("Export Error: Headless export while export is in progress."));
+		fail("in_progress");
+		return;
+	}
+	const auto settings = ReadRunnerSettings(settingsPath);
+	if (!settings) {
+		fail("bad_settings");
+		return;
+	}
+	LOG(("Export Info: Started headless export to '%1'."
+		).arg(settings->path));
+
+	_runner = std::make_unique<Runner>(session, *settings);
+	session->account().sessionChanges(
+	) | rpl::filter([=](Main::Session *value) {
+		return (value != session);
+	}) | rpl::start_with_next([=] {
+		// Don't destroy the runner while it is firing.
+		crl::on_main([=] {
+			stopHeadless("session_changed");
+		});
+	}, _runner->lifetime());
+
+	_runner->done(
+	) | rpl::start_with_next([=] {
+		crl::on_main([=] {
+			stopHeadless("stopped");
+		});
+	}, _runner->lifetime());
+}
+
 rpl::producer<View::PanelController*> Manager::currentView(
 ) const {
 	return _viewChanges.events_starting_with(_panel.get());
 }
 
 bool Manager::inProgress() const {
-	return _controller != nullptr;
+	return (_controller != nullptr) || (_runner != nullptr);
 }
 
 bool Manager::inProgress(not_null<Main::Session*> session) const {
@@ -69,6 +111,7 @@ bool Manager::inProgress(not_null<Main::Session*> session) const {
 
 void Manager::stopWithConfirmation(FnMut<void()> callback) {
 	if (!_panel) {
+		stop();
 		callback();
 		return;
 	}
@@ -90,6 +133,16 @@ void Manager::stop() {
 		_viewChanges.fire(nullptr);
 	}
 	_controller = nullptr;
+	stopHeadless("stopped");
+}
+
+void Manager::stopHeadless(const QString &reason) {
+	if (!_runner) {
+		return;
+	}
+	_runner->abort(reason);
+	_runner = nullptr;
+	App::quit();
 }
 
 } // namespace Export
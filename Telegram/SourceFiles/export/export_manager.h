@@ -20,6 +20,7 @@ class Session;
 namespace Export {
 
 class Controller;
+class Runner;
 
 namespace View {
 class PanelController;
@@ -35,6 +36,11 @@ public:
 		not_null<Main::Session*> session,
 		const MTPInputPeer &singlePeer = MTP_inputPeerEmpty());
 
+	// Exports without the panels and quits when it is done.
+	void startHeadless(
+		not_null<Main::Session*> session,
+		const QString &settingsPath);
+
 	[[nodiscard]] rpl::producer<View::PanelController*> currentView() const;
 	[[nodiscard]] bool inProgress() const;
 	[[nodiscard]] bool inProgress(not_null<Main::Session*> session) const;
@@ -42,8 +48,11 @@ public:
 	void stop();
 
 private:
+	void stopHeadless(const QString &reason);
+
 	std::unique_ptr<Controller> _controller;
 	std::unique_ptr<View::PanelController> _panel;
+	std::unique_ptr<Runner> _runner;
 	rpl::event_stream<View::PanelController*> _viewChanges;
 
 };
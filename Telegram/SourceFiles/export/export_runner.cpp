@@ -0,0 +1,278 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "export/export_runner.h"
+
+#include "export/output/export_output_abstract.h"
+#include "export/view/export_view_panel_controller.h"
+#include "main/main_session.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonArray>
+
+#include <cstdio>
+
+namespace Export {
+namespace {
+
+constexpr auto kProgressDelay = crl::time(500);
+
+using Type = Settings::Type;
+using MediaType = MediaSettings::Type;
+
+const auto kTypeNames = base::flat_map<QString, Type>{
+	{ "personal_info", Type::PersonalInfo },
+	{ "userpics", Type::Userpics },
+	{ "contacts", Type::Contacts },
+	{ "sessions", Type::Sessions },
+	{ "other_data", Type::OtherData },
+	{ "personal_chats", Type::PersonalChats },
+	{ "bot_chats", Type::BotChats },
+	{ "private_groups", Type::PrivateGroups },
+	{ "public_groups", Type::PublicGroups },
+	{ "private_channels", Type::PrivateChannels },
+	{ "public_channels", Type::PublicChannels },
+};
+
+const auto kMediaTypeNames = base::flat_map<QString, MediaType>{
+	{ "photo", MediaType::Photo },
+	{ "video", MediaType::Video },
+	{ "voice_message", MediaType::VoiceMessage },
+	{ "video_message", MediaType::VideoMessage },
+	{ "sticker", MediaType::Sticker },
+	{ "gif", MediaType::GIF },
+	{ "file", MediaType::File },
+};
+
+template <typename Flag>
+[[nodiscard]] std::optional<base::flags<Flag>> ReadFlags(
+		const QJsonValue &value,
+		const base::flat_map<QString, Flag> &names) {
+	if (!value.isArray()) {
+		LOG(("Export Error: Not an array of types in runner settings."));
+		return std::nullopt;
+	}
+	auto result = base::flags<Flag>();
+	for (const auto &name : value.toArray()) {
+		const auto i = names.find(name.toString());
+		if (i == end(names)) {
+			LOG(("Export Error: Unknown type '%1' in runner settings."
+				).arg(name.toString()));
+			return std::nullopt;
+		}
+		result |= i->second;
+	}
+	return result;
+}
+
+[[nodiscard]] QString StepName(ProcessingState::Step step) {
+	using Step = ProcessingState::Step;
+	switch (step) {
+	case Step::Initializing: return "initializing";
+	case Step::DialogsList: return "dialogs_list";
+	case Step::PersonalInfo: return "personal_info";
+	case Step::Userpics: return "userpics";
+	case Step::Contacts: return "contacts";
+	case Step::Sessions: return "sessions";
+	case Step::OtherData: return "other_data";
+	case Step::Dialogs: return "dialogs";
+	}
+	Unexpected("Step in Export::StepName.");
+}
+
+void WriteLine(const QJsonObject &object) {
+	const auto line = QJsonDocument(object).toJson(QJsonDocument::Compact)
+		+ '\n';
+	std::fwrite(line.constData(), 1, line.size(), stdout);
+	std::fflush(stdout);
+}
+
+} // namespace
+
+std::optional<Settings> ReadRunnerSettings(const QString &path) {
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		LOG(("Export Error: Could not open runner settings '%1'."
+			).arg(path));
+		return std::nullopt;
+	}
+	auto error = QJsonParseError{ 0, QJsonParseError::NoError };
+	const auto document = QJsonDocument::fromJson(file.readAll(), &error);
+	if (error.error != QJsonParseError::NoError) {
+		LOG(("Export Error: Failed to parse runner settings, error: %1"
+			).arg(error.errorString()));
+		return std::nullopt;
+	} else if (!document.isObject()) {
+		LOG(("Export Error: Not an object in runner settings."));
+		return std::nullopt;
+	}
+	const auto object = document.object();
+
+	auto result = Settings();
+	result.path = object.value("path").toString();
+	if (result.path.isEmpty()) {
+		LOG(("Export Error: No path in runner settings."));
+		return std::nullopt;
+	}
+
+	const auto format = object.value("format").toString("html");
+	if (format == "html") {
+		result.format = Output::Format::Html;
+	} else if (format == "json") {
+		result.format = Output::Format::Json;
+	} else {
+		LOG(("Export Error: Unknown format '%1' in runner settings."
+			).arg(format));
+		return std::nullopt;
+	}
+
+	if (object.contains("types")) {
+		const auto types = ReadFlags(object.value("types"), kTypeNames);
+		if (!types) {
+			return std::nullopt;
+		}
+		result.types = *types;
+	}
+	if (object.contains("media_types")) {
+		const auto types = ReadFlags(
+			object.value("media_types"),
+			kMediaTypeNames);
+		if (!types) {
+			return std::nullopt;
+		}
+		result.media.types = *types;
+	}
+
+	const auto readInt = [&](const char *key, int &value) {
+		value = object.value(key).toInt(value);
+	};
+	readInt("media_size_limit", result.media.sizeLimit);
+	readInt("files_in_flight", result.filesInFlight);
+	readInt("file_parts_in_flight", result.filePartsInFlight);
+	readInt("slices_prefetch", result.slicesPrefetch);
+	readInt("dialogs_in_flight", result.dialogsInFlight);
+	readInt("output_buffer_size", result.outputBufferSize);
+	result.media.sharedFolder = object.value("media_shared_folder").toBool(
+		result.media.sharedFolder);
+
+	if (!result.validate()) {
+		LOG(("Export Error: Bad values in runner settings."));
+		return std::nullopt;
+	}
+	return result;
+}
+
+void WriteRunnerError(const QString &reason) {
+	WriteLine({
+		{ "state", "error" },
+		{ "reason", reason },
+	});
+}
+
+Runner::Runner(not_null<Main::Session*> session, const Settings &settings)
+: _controller(&session->mtp(), settings.singlePeer)
+, _started(crl::now()) {
+	_controller.state(
+	) | rpl::start_with_next([=](const State &state) {
+		handleState(state);
+	}, _lifetime);
+
+	auto resolved = settings;
+	View::ResolveSettings(session, resolved);
+	_controller.startExport(resolved, View::PrepareEnvironment(session));
+}
+
+Runner::~Runner() = default;
+
+rpl::producer<> Runner::done() const {
+	return _done.events();
+}
+
+rpl::lifetime &Runner::lifetime() {
+	return _lifetime;
+}
+
+void Runner::abort(const QString &reason) {
+	if (_finished) {
+		return;
+	}
+	LOG(("Export Info: Headless export aborted, reason: %1").arg(reason));
+	finish({
+		{ "state", "error" },
+		{ "reason", reason },
+	});
+}
+
+void Runner::handleState(const State &state) {
+	if (_finished) {
+		return;
+	}
+	v::match(state, [&](const PasswordCheckState &) {
+	}, [&](const ProcessingState &data) {
+		writeProgress(data);
+	}, [&](const ApiErrorState &data) {
+		finish({
+			{ "state", "api_error" },
+			{ "type", data.data.type() },
+			{ "code", data.data.code() },
+		});
+	}, [&](const OutputErrorState &data) {
+		finish({
+			{ "state", "output_error" },
+			{ "path", data.path },
+		});
+	}, [&](const CancelledState &) {
+		finish({ { "state", "cancelled" } });
+	}, [&](const FinishedState &data) {
+		finish({
+			{ "state", "finished" },
+			{ "path", data.path },
+			{ "files", data.filesCount },
+			{ "bytes", double(data.bytesCount) },
+		});
+	});
+}
+
+void Runner::writeProgress(const ProcessingState &state) {
+	// Every loaded file part changes the state, write only some of them.
+	const auto now = crl::now();
+	if (state.step == _lastStep
+		&& state.entityIndex == _lastEntityIndex
+		&& now - _lastProgress < kProgressDelay) {
+		return;
+	}
+	_lastStep = state.step;
+	_lastEntityIndex = state.entityIndex;
+	_lastProgress = now;
+	write({
+		{ "state", "processing" },
+		{ "step", StepName(state.step) },
+		{ "substeps_passed", state.substepsPassed },
+		{ "substeps_total", state.substepsTotal },
+		{ "entity_index", state.entityIndex },
+		{ "entity_count", state.entityCount },
+		{ "item_index", state.itemIndex },
+		{ "item_count", state.itemCount },
+		{ "bytes_loaded", state.bytesLoaded },
+		{ "bytes_count", state.bytesCount },
+	});
+}
+
+void Runner::write(QJsonObject &&object) {
+	object.insert("elapsed_ms", double(crl::now() - _started));
+	WriteLine(object);
+}
+
+void Runner::finish(QJsonObject &&object) {
+	_finished = true;
+	write(std::move(object));
+	_done.fire({});
+}
+
+} // namespace Export
@@ -0,0 +1,73 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "export/export_controller.h"
+#include "export/export_settings.h"
+
+namespace Main {
+class Session;
+} // namespace Main
+
+namespace Export {
+
+// Reads the export settings for the -exportrun launcher mode from a JSON
+// file, for example:
+//
+// {
+//   "path": "/tmp/export",
+//   "format": "json",
+//   "types": [ "personal_info", "contacts", "personal_chats" ],
+//   "media_types": [ "photo", "sticker" ],
+//   "media_size_limit": 1048576,
+//   "media_shared_folder": true,
+//   "files_in_flight": 4
+// }
+//
+// Only "path" is required, the other fields have the usual defaults.
+[[nodiscard]] std::optional<Settings> ReadRunnerSettings(
+	const QString &path);
+
+// Writes the final line for an export that couldn't start at all.
+void WriteRunnerError(const QString &reason);
+
+// Drives an export without the panels and writes the progress and the
+// final stats to stdout as one JSON object per line, so that it can be
+// used for batch exports and throughput measurements.
+class Runner final {
+public:
+	Runner(not_null<Main::Session*> session, const Settings &settings);
+	~Runner();
+
+	// Fires when the export is finished, failed or cancelled.
+	[[nodiscard]] rpl::producer<> done() const;
+
+	[[nodiscard]] rpl::lifetime &lifetime();
+
+	// Writes the final error line, unless the export is already done.
+	void abort(const QString &reason);
+
+private:
+	void handleState(const State &state);
+	void writeProgress(const ProcessingState &state);
+	void write(QJsonObject &&object);
+	void finish(QJsonObject &&object);
+
+	Controller _controller;
+	crl::time _started = 0;
+	crl::time _lastProgress = 0;
+	ProcessingState::Step _lastStep = ProcessingState::Step::Initializing;
+	int _lastEntityIndex = -1;
+	bool _finished = false;
+	rpl::event_stream<> _done;
+
+	rpl::lifetime _lifetime;
+
+};
+
+} // namespace Export
@@ -43,6 +43,12 @@ bool Settings::validate() const {
 		return false;
 	} else if (singlePeerTill > 0 && singlePeerTill <= singlePeerFrom) {
 		return false;
+	} else if (filesInFlight < 1 || filePartsInFlight < 1) {
+		return false;
+	} else if (slicesPrefetch < 0 || dialogsInFlight < 1) {
+		return false;
+	} else if (outputBufferSize < 0) {
+		return false;
 	}
 	return true;
 };
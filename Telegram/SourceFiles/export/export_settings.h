@@ -36,6 +36,10 @@ struct MediaSettings {
 	Types types = DefaultTypes();
 	int sizeLimit = 8 * 1024 * 1024;
 
+	// Each photo and document is written once to the shared "media"
+	// folder, named by its id, and all the chats link to that file.
+	bool sharedFolder = false;
+
 	static inline Types DefaultTypes() {
 		return Type::Photo;
 	}
@@ -83,6 +87,23 @@ struct Settings {
 
 	TimeId availableAt = 0;
 
+	// How many media files are loaded at the same time
+	// and how many parts of each file are requested at the same time.
+	int filesInFlight = 4;
+	int filePartsInFlight = 2;
+
+	// How many messages slices are requested ahead of the one
+	// which files are being loaded, zero to request them one by one.
+	int slicesPrefetch = 2;
+
+	// How many dialogs are loaded at the same time, they're still
+	// written one by one in the dialogs list order.
+	int dialogsInFlight = 2;
+
+	// How many bytes of the output files are collected in memory
+	// before they're written to the disk.
+	int outputBufferSize = 128 * 1024;
+
 	bool onlySinglePeer() const {
 		return singlePeer.type() != mtpc_inputPeerEmpty;
 	}
@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "export/output/export_output_abstract.h"
 
+#include "export/output/export_output_checkpoint.h"
 #include "export/output/export_output_html.h"
 #include "export/output/export_output_json.h"
 #include "export/output/export_output_stats.h"
@@ -29,6 +30,15 @@ QString NormalizePath(const Settings &settings) {
 	const auto list = folder.entryInfoList(mode);
 	if (list.isEmpty() && !settings.forceSubPath) {
 		return result;
+	} else if (!settings.forceSubPath && Checkpoint::Exists(result)) {
+		// Continue the export that was written there before.
+		return result;
+	} else if (!settings.onlySinglePeer()) {
+		// Or the latest one written to a subfolder, as the default one.
+		const auto latest = Checkpoint::FindLatest(result);
+		if (!latest.isEmpty()) {
+			return latest;
+		}
 	}
 	const auto date = QDate::currentDate();
 	const auto base = QString(settings.onlySinglePeer()
@@ -71,6 +71,13 @@ public:
 	[[nodiscard]] virtual Result writeDialogSlice(
 		const Data::MessagesSlice &data) = 0;
 	[[nodiscard]] virtual Result writeDialogEnd() = 0;
+
+	// Lists the chat that was written to its folder by a previous export.
+	[[nodiscard]] virtual bool canWriteFinishedDialog() = 0;
+	[[nodiscard]] virtual Result writeFinishedDialog(
+		const Data::DialogInfo &data,
+		int messagesCount) = 0;
+
 	[[nodiscard]] virtual Result writeDialogsEnd() = 0;
 
 	[[nodiscard]] virtual Result finish() = 0;
@@ -0,0 +1,266 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "export/output/export_output_checkpoint.h"
+
+#include "export/output/export_output_file.h"
+#include "export/output/export_output_result.h"
+#include "export/export_settings.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+
+namespace Export {
+namespace Output {
+namespace {
+
+const auto kFileName = QString("export_checkpoint.txt");
+const auto kHeader = QByteArray("tdesktop-export-checkpoint 1");
+
+QByteArray ComposeSettingsKey(const Settings &settings) {
+	// The chats written with other settings may have other contents.
+	return "s "
+		+ QByteArray::number(int(settings.format))
+		+ ' '
+		+ QByteArray::number(quint32(settings.types))
+		+ ' '
+		+ QByteArray::number(quint32(settings.fullChats))
+		+ ' '
+		+ QByteArray::number(quint32(settings.media.types))
+		+ ' '
+		+ QByteArray::number(settings.media.sizeLimit)
+		+ '\n';
+}
+
+QByteArray SerializeFile(
+		Checkpoint::FileKey key,
+		const QString &relativePath,
+		int64 size) {
+	// Paths are percent-encoded, so that they have no spaces or newlines.
+	return "f "
+		+ QByteArray::number(key.type)
+		+ ' '
+		+ QByteArray::number(key.id)
+		+ ' '
+		+ QByteArray::number(size)
+		+ ' '
+		+ relativePath.toUtf8().toPercentEncoding()
+		+ '\n';
+}
+
+QByteArray SerializeDialog(
+		uint64 peerId,
+		const Checkpoint::FinishedDialog &dialog) {
+	return "d "
+		+ QByteArray::number(peerId)
+		+ ' '
+		+ QByteArray::number(dialog.topMessageId)
+		+ ' '
+		+ QByteArray::number(dialog.messagesCount)
+		+ ' '
+		+ dialog.relativePath.toUtf8().toPercentEncoding()
+		+ '\n';
+}
+
+bool GoodRelativePath(const QString &relativePath) {
+	return !relativePath.isEmpty()
+		&& !relativePath.startsWith('/')
+		&& !relativePath.contains(':')
+		&& !relativePath.split('/').contains(QString(".."));
+}
+
+} // namespace
+
+Checkpoint::Checkpoint() = default;
+
+Checkpoint::~Checkpoint() = default;
+
+bool Checkpoint::Exists(const QString &folder) {
+	return QFile::exists(folder + kFileName);
+}
+
+QString Checkpoint::FindLatest(const QString &folder) {
+	auto result = QString();
+	auto modified = QDateTime();
+	const auto list = QDir(folder).entryInfoList(
+		{ "DataExport_*" },
+		QDir::Dirs | QDir::NoDotAndDotDot);
+	for (const auto &entry : list) {
+		const auto path = entry.absoluteFilePath() + '/';
+		const auto info = QFileInfo(path + kFileName);
+		if (info.isFile()
+			&& (result.isEmpty() || info.lastModified() > modified)) {
+			result = path;
+			modified = info.lastModified();
+		}
+	}
+	return result;
+}
+
+Result Checkpoint::start(const Settings &settings) {
+	Expects(_file == nullptr);
+
+	_folder = settings.path;
+	_settingsKey = ComposeSettingsKey(settings);
+	read(_settingsKey);
+	return rewrite();
+}
+
+Result Checkpoint::finish() {
+	return _file ? _file->flush() : Result::Success();
+}
+
+Result Checkpoint::rewrite() {
+	auto block = kHeader + '\n' + _settingsKey;
+	for (const auto &[key, stored] : _files) {
+		block.append(SerializeFile(key, stored.relativePath, stored.size));
+	}
+	for (const auto &[peerId, dialog] : _dialogs) {
+		block.append(SerializeDialog(peerId, dialog));
+	}
+
+	// A new file writes from the beginning.
+	_file = std::make_unique<File>(_folder + kFileName, nullptr);
+	return write(block);
+}
+
+void Checkpoint::read(const QByteArray &settingsKey) {
+	QFile file(_folder + kFileName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+	const auto lines = file.readAll().split('\n');
+	if (lines.isEmpty() || lines.front() != kHeader) {
+		return;
+	}
+
+	const auto sameSettings = (lines.size() > 2)
+		&& (lines[1] + '\n' == settingsKey);
+
+	// The last part is either empty or a line that wasn't written fully.
+	for (auto i = 1; i + 1 < lines.size(); ++i) {
+		const auto parts = lines[i].split(' ');
+		if (parts.size() == 5 && parts[0] == "f") {
+			auto typeOk = false;
+			auto idOk = false;
+			auto sizeOk = false;
+			const auto key = FileKey{
+				parts[1].toULongLong(&typeOk),
+				parts[2].toULongLong(&idOk),
+			};
+			const auto size = parts[3].toLongLong(&sizeOk);
+			const auto relativePath = QString::fromUtf8(
+				QByteArray::fromPercentEncoding(parts[4]));
+			if (!typeOk
+				|| !idOk
+				|| !sizeOk
+				|| !GoodRelativePath(relativePath)) {
+				continue;
+			}
+
+			// Skip the files that were removed or changed since then.
+			const auto info = QFileInfo(_folder + relativePath);
+			if (info.isFile() && info.size() == size) {
+				_files[key] = StoredFile{ relativePath, size };
+			}
+		} else if (parts.size() == 5 && parts[0] == "d" && sameSettings) {
+			auto peerOk = false;
+			auto messageOk = false;
+			auto countOk = false;
+			const auto peerId = parts[1].toULongLong(&peerOk);
+			auto dialog = FinishedDialog{
+				parts[2].toInt(&messageOk),
+				parts[3].toInt(&countOk),
+				QString::fromUtf8(QByteArray::fromPercentEncoding(parts[4])),
+			};
+			if (!peerOk
+				|| !messageOk
+				|| !countOk
+				|| !GoodRelativePath(dialog.relativePath)
+				|| !dialog.relativePath.endsWith('/')) {
+				continue;
+			}
+
+			// Skip the chats that were removed since then.
+			const auto main = _folder + dialog.relativePath + "messages.html";
+			if (!dialog.messagesCount || QFileInfo(main).isFile()) {
+				_dialogs[peerId] = std::move(dialog);
+			}
+		}
+	}
+}
+
+std::optional<QString> Checkpoint::findFile(FileKey key) const {
+	const auto i = _files.find(key);
+	if (i == end(_files)) {
+		return std::nullopt;
+	}
+	return i->second.relativePath;
+}
+
+Result Checkpoint::saveFile(
+		FileKey key,
+		const QString &relativePath,
+		int64 size) {
+	if (!_file) {
+		return Result::Success();
+	}
+	_files[key] = StoredFile{ relativePath, size };
+	return write(SerializeFile(key, relativePath, size));
+}
+
+auto Checkpoint::findDialog(uint64 peerId) const -> const FinishedDialog* {
+	const auto i = _dialogs.find(peerId);
+	return (i != end(_dialogs)) ? &i->second : nullptr;
+}
+
+Result Checkpoint::saveDialog(
+		uint64 peerId,
+		const FinishedDialog &dialog) {
+	if (!_file) {
+		return Result::Success();
+	}
+	_dialogs[peerId] = dialog;
+	return write(SerializeDialog(peerId, dialog));
+}
+
+Result Checkpoint::keepDialogs(const base::flat_set<uint64> &peerIds) {
+	if (!_file) {
+		return Result::Success();
+	}
+	auto removed = false;
+	for (auto i = begin(_dialogs); i != end(_dialogs);) {
+		if (peerIds.contains(i->first)) {
+			++i;
+		} else {
+			i = _dialogs.erase(i);
+			removed = true;
+		}
+	}
+	return removed ? rewrite() : Result::Success();
+}
+
+int Checkpoint::filesCount() const {
+	return int(_files.size());
+}
+
+int Checkpoint::dialogsCount() const {
+	return int(_dialogs.size());
+}
+
+Result Checkpoint::write(const QByteArray &bytes) {
+	Expects(_file != nullptr);
+
+	// Don't keep the records in the file buffer, a crash would lose them.
+	const auto result = _file->writeBlock(bytes);
+	return result ? _file->flush() : result;
+}
+
+} // namespace Output
+} // namespace Export
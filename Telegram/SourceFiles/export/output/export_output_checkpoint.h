@@ -0,0 +1,103 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/optional.h"
+#include "base/flat_set.h"
+
+#include <QtCore/QString>
+
+#include <map>
+
+namespace Export {
+
+struct Settings;
+
+namespace Output {
+
+struct Result;
+class File;
+
+// The media files and the chats already written to the export folder,
+// appended and flushed one line at a time so that it survives a cancel or
+// a crash.
+//
+// When an export goes to a folder with such a list the files that are
+// still on the disk with the same size are not loaded again. In the html
+// format every chat is written to its own folder, so the chats that have
+// the same top message as when they were written are not loaded again
+// either, if the export settings are the same.
+class Checkpoint final {
+public:
+	struct FileKey {
+		uint64 type = 0;
+		uint64 id = 0;
+
+		inline bool operator<(const FileKey &other) const {
+			return std::tie(type, id) < std::tie(other.type, other.id);
+		}
+	};
+
+	struct FinishedDialog {
+		int32 topMessageId = 0;
+		int messagesCount = 0;
+		QString relativePath;
+	};
+
+	Checkpoint();
+	Checkpoint(const Checkpoint &other) = delete;
+	Checkpoint &operator=(const Checkpoint &other) = delete;
+	~Checkpoint();
+
+	[[nodiscard]] static bool Exists(const QString &folder);
+
+	// The "DataExport_*" subfolder with the latest written list, if any.
+	[[nodiscard]] static QString FindLatest(const QString &folder);
+
+	// Reads the list from settings.path, if there is one, and writes back
+	// only the entries that are still valid.
+	[[nodiscard]] Result start(const Settings &settings);
+	[[nodiscard]] Result finish();
+
+	[[nodiscard]] std::optional<QString> findFile(FileKey key) const;
+	[[nodiscard]] Result saveFile(
+		FileKey key,
+		const QString &relativePath,
+		int64 size);
+
+	[[nodiscard]] const FinishedDialog *findDialog(uint64 peerId) const;
+	[[nodiscard]] Result saveDialog(
+		uint64 peerId,
+		const FinishedDialog &dialog);
+
+	// Forgets the other chats, their folders may be written by others.
+	[[nodiscard]] Result keepDialogs(const base::flat_set<uint64> &peerIds);
+
+	[[nodiscard]] int filesCount() const;
+	[[nodiscard]] int dialogsCount() const;
+
+private:
+	struct StoredFile {
+		QString relativePath;
+		int64 size = 0;
+	};
+
+	void read(const QByteArray &settingsKey);
+	[[nodiscard]] Result rewrite();
+	[[nodiscard]] Result write(const QByteArray &bytes);
+
+	QString _folder;
+	QByteArray _settingsKey;
+	std::unique_ptr<File> _file;
+	std::map<FileKey, StoredFile> _files;
+	std::map<uint64, FinishedDialog> _dialogs;
+
+};
+
+} // namespace Output
+} // namespace Export
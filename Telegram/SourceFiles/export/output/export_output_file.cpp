@@ -18,15 +18,25 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace Export {
 namespace Output {
 
-File::File(const QString &path, Stats *stats) : _path(path), _stats(stats) {
+File::File(const QString &path, Stats *stats, int bufferSize)
+: _path(path)
+, _bufferSize(bufferSize)
+, _lastWrite(crl::now())
+, _stats(stats) {
+}
+
+File::~File() {
+	if (!_buffer.isEmpty()) {
+		[[maybe_unused]] const auto result = flush();
+	}
 }
 
 int File::size() const {
-	return _offset;
+	return _offset + _buffer.size();
 }
 
 bool File::empty() const {
-	return !_offset;
+	return !size();
 }
 
 Result File::writeBlock(const QByteArray &block) {
@@ -37,22 +47,57 @@ Result File::writeBlock(const QByteArray &block) {
 	return result;
 }
 
+Result File::flush() {
+	const auto result = flushAttempt();
+	if (!result) {
+		_file.reset();
+	}
+	return result;
+}
+
 Result File::writeBlockAttempt(const QByteArray &block) {
 	if (_stats && !_inStats) {
 		_inStats = true;
 		_stats->incrementFiles();
 	}
-	if (const auto result = reopen(); !result) {
-		return result;
+	if (block.isEmpty()) {
+		// Even an empty file should be created on the disk.
+		return reopen();
+	} else if (_buffer.isEmpty() && block.size() >= _bufferSize) {
+		return writeToDisk(block);
+	}
+	if (_buffer.isEmpty()) {
+		_buffer.reserve(_bufferSize);
 	}
-	const auto size = block.size();
-	if (!size) {
+	_buffer.append(block);
+	if (_buffer.size() < _bufferSize
+		&& crl::now() - _lastWrite < kFlushDelay) {
 		return Result::Success();
 	}
-	if (_file->write(block) == size && _file->flush()) {
+	return flushAttempt();
+}
+
+Result File::flushAttempt() {
+	if (_buffer.isEmpty()) {
+		return Result::Success();
+	} else if (const auto result = writeToDisk(_buffer); !result) {
+		return result;
+	}
+	_buffer.resize(0);
+	return Result::Success();
+}
+
+Result File::writeToDisk(const QByteArray &bytes) {
+	if (const auto result = reopen(); !result) {
+		return result;
+	}
+	const auto size = bytes.size();
+	if (_file->write(bytes) == size && _file->flush()) {
 		_offset += size;
+		_lastWrite = crl::now();
 		if (_stats) {
 			_stats->incrementBytes(size);
+			_stats->incrementWrites();
 		}
 		return Result::Success();
 	}
@@ -95,8 +140,13 @@ Result File::fatalError() const {
 
 QString File::PrepareRelativePath(
 		const QString &folder,
-		const QString &suggested) {
-	if (!QFile::exists(folder + suggested)) {
+		const QString &suggested,
+		const base::flat_set<QString> &reserved) {
+	const auto taken = [&](const QString &relativePath) {
+		return reserved.contains(relativePath)
+			|| QFile::exists(folder + relativePath);
+	};
+	if (!taken(suggested)) {
 		return suggested;
 	}
 
@@ -114,7 +164,7 @@ QString File::PrepareRelativePath(
 	auto attempt = 0;
 	while (true) {
 		const auto relativePath = relativePart(++attempt);
-		if (!QFile::exists(folder + relativePath)) {
+		if (!taken(relativePath)) {
 			return relativePath;
 		}
 	}
@@ -132,7 +182,11 @@ Result File::Copy(
 	if (bytes.size() != f.size()) {
 		return Result(Result::Type::FatalError, source);
 	}
-	return File(path, stats).writeBlock(bytes);
+	auto file = File(path, stats);
+	if (const auto result = file.writeBlock(bytes); !result) {
+		return result;
+	}
+	return file.flush();
 }
 
 } // namespace Output
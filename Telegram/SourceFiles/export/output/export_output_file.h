@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/optional.h"
+#include "base/flat_set.h"
 
 #include <QtCore/QFile>
 #include <QtCore/QString>
@@ -19,18 +20,40 @@ namespace Output {
 struct Result;
 class Stats;
 
+// Small blocks are collected in memory and written to the disk together
+// when there are 'bufferSize' bytes of them or when a block is added and
+// the last write was kFlushDelay ago. Blocks not smaller than the buffer
+// go directly. Nothing is written while no blocks are added, so only the
+// files completed by flush() are safe from a crash, and even those are
+// handed to the system without waiting for them to reach the disk.
 class File {
 public:
-	File(const QString &path, Stats *stats);
+	static constexpr auto kDefaultBufferSize = 128 * 1024;
+	static constexpr auto kFlushDelay = crl::time(5000);
+
+	File(
+		const QString &path,
+		Stats *stats,
+		int bufferSize = kDefaultBufferSize);
+	File(const File &other) = delete;
+	File &operator=(const File &other) = delete;
+	~File();
 
 	[[nodiscard]] int size() const;
 	[[nodiscard]] bool empty() const;
 
 	[[nodiscard]] Result writeBlock(const QByteArray &block);
 
+	// Writes all the buffered blocks, should be called when the last
+	// block is written, the destructor doesn't report errors.
+	[[nodiscard]] Result flush();
+
+	// Paths in 'reserved' are treated as taken, even if they're not
+	// created on the disk yet by the files being written.
 	[[nodiscard]] static QString PrepareRelativePath(
 		const QString &folder,
-		const QString &suggested);
+		const QString &suggested,
+		const base::flat_set<QString> &reserved = {});
 
 	[[nodiscard]] static Result Copy(
 		const QString &source,
@@ -40,6 +63,8 @@ public:
 private:
 	[[nodiscard]] Result reopen();
 	[[nodiscard]] Result writeBlockAttempt(const QByteArray &block);
+	[[nodiscard]] Result flushAttempt();
+	[[nodiscard]] Result writeToDisk(const QByteArray &bytes);
 
 	[[nodiscard]] Result error() const;
 	[[nodiscard]] Result fatalError() const;
@@ -48,6 +73,10 @@ private:
 	int _offset = 0;
 	std::optional<QFile> _file;
 
+	QByteArray _buffer;
+	int _bufferSize = 0;
+	crl::time _lastWrite = 0;
+
 	Stats *_stats = nullptr;
 	bool _inStats = false;
 
@@ -34,6 +34,7 @@ constexpr auto kStickerMaxWidth = 384;
 constexpr auto kStickerMaxHeight = 384;
 constexpr auto kStickerMinWidth = 80;
 constexpr auto kStickerMinHeight = 80;
+constexpr auto kSliceBlockReserve = 256 * 1024;
 
 const auto kLineBreak = QByteArrayLiteral("<br>");
 
@@ -91,15 +92,45 @@ auto CalculateThumbSize(
 	};
 }
 
+[[nodiscard]] inline bool NeedsEscape(char ch) {
+	return (ch >= 0 && ch < 32)
+		|| (ch == '"')
+		|| (ch == '&')
+		|| (ch == '\'')
+		|| (ch == '<')
+		|| (ch == '>')
+		|| (ch == char(0xE2));
+}
+
 QByteArray SerializeString(const QByteArray &value) {
 	const auto size = value.size();
 	const auto begin = value.data();
 	const auto end = begin + size;
 
+	// Most of the text doesn't need escaping at all,
+	// so the parts between escaped characters are copied in one piece.
 	auto result = QByteArray();
-	result.reserve(size * 6);
+	result.reserve(size + (size >> 3));
+	auto from = begin;
 	for (auto p = begin; p != end; ++p) {
 		const auto ch = *p;
+		if (!NeedsEscape(ch)) {
+			continue;
+		} else if (ch == char(0xE2)) {
+			if (p + 2 >= end
+				|| *(p + 1) != char(0x80)
+				|| (*(p + 2) != char(0xA8) && *(p + 2) != char(0xA9))) {
+				continue;
+			}
+			// Line and paragraph separators.
+			result.append(from, p - from);
+			result.append("<br>", 4);
+			p += 2;
+			from = p + 1;
+			continue;
+		}
+		result.append(from, p - from);
+		from = p + 1;
 		if (ch == '\n') {
 			result.append("<br>", 4);
 		} else if (ch == '"') {
@@ -112,7 +143,7 @@ QByteArray SerializeString(const QByteArray &value) {
 			result.append("&lt;", 4);
 		} else if (ch == '>') {
 			result.append("&gt;", 4);
-		} else if (ch >= 0 && ch < 32) {
+		} else {
 			result.append("&#x", 3).append('0' + (ch >> 4));
 			const auto left = (ch & 0x0F);
 			if (left >= 10) {
@@ -121,20 +152,9 @@ QByteArray SerializeString(const QByteArray &value) {
 				result.append('0' + left);
 			}
 			result.append(';');
-		} else if (ch == char(0xE2)
-			&& (p + 2 < end)
-			&& *(p + 1) == char(0x80)) {
-			if (*(p + 2) == char(0xA8)) { // Line separator.
-				result.append("<br>", 4);
-			} else if (*(p + 2) == char(0xA9)) { // Paragraph separator.
-				result.append("<br>", 4);
-			} else {
-				result.append(ch);
-			}
-		} else {
-			result.append(ch);
 		}
 	}
+	result.append(from, end - from);
 	return result;
 }
 
@@ -528,7 +548,11 @@ struct HtmlWriter::MessageInfo {
 
 class HtmlWriter::Wrap {
 public:
-	Wrap(const QString &path, const QString &base, Stats *stats);
+	Wrap(
+		const QString &path,
+		const QString &base,
+		Stats *stats,
+		int bufferSize);
 
 	[[nodiscard]] bool empty() const;
 
@@ -694,8 +718,9 @@ QString WriteUserpicThumb(
 HtmlWriter::Wrap::Wrap(
 	const QString &path,
 	const QString &base,
-	Stats *stats)
-: _file(path, stats) {
+	Stats *stats,
+	int bufferSize)
+: _file(path, stats, bufferSize) {
 	Expects(base.endsWith('/'));
 	Expects(path.startsWith(base));
 
@@ -1801,7 +1826,10 @@ Result HtmlWriter::Wrap::close() {
 		while (!_context.empty()) {
 			block.append(_context.popTag());
 		}
-		return _file.writeBlock(block);
+		if (const auto result = _file.writeBlock(block); !result) {
+			return result;
+		}
+		return _file.flush();
 	}
 	return Result::Success();
 }
@@ -2392,7 +2420,11 @@ Result HtmlWriter::writeDialogSlice(const Data::MessagesSlice &data) {
 		: 0;
 	auto previous = _lastMessageInfo.get();
 	auto saved = std::optional<MessageInfo>();
-	auto block = QByteArray();
+
+	// The buffer keeps its capacity between the slices.
+	auto &block = _sliceBlock;
+	block.reserve(kSliceBlockReserve);
+	block.resize(0);
 	for (const auto &message : data.list) {
 		if (Data::SkipMessageByDate(message, _settings)) {
 			continue;
@@ -2406,7 +2438,7 @@ Result HtmlWriter::writeDialogSlice(const Data::MessagesSlice &data) {
 				_lastMessageIdsPerFile.push_back(saved
 					? saved->id
 					: _lastMessageInfo->id);
-				block = QByteArray();
+				block.resize(0);
 				_lastMessageInfo = nullptr;
 				previous = nullptr;
 				saved = std::nullopt;
@@ -2479,6 +2511,26 @@ Result HtmlWriter::writeDialogEnd() {
 	} else if (_settings.onlySinglePeer()) {
 		return Result::Success();
 	}
+	return writeDialogListEntry();
+}
+
+bool HtmlWriter::canWriteFinishedDialog() {
+	return !_settings.onlySinglePeer();
+}
+
+Result HtmlWriter::writeFinishedDialog(
+		const Data::DialogInfo &data,
+		int messagesCount) {
+	Expects(_chats != nullptr);
+	Expects(_chat == nullptr);
+
+	_dialog = data;
+	_messagesCount = messagesCount;
+	return writeDialogListEntry();
+}
+
+Result HtmlWriter::writeDialogListEntry() {
+	Expects(_chats != nullptr);
 
 	using Type = Data::DialogInfo::Type;
 	const auto TypeString = [](Type type) {
@@ -2755,7 +2807,8 @@ std::unique_ptr<HtmlWriter::Wrap> HtmlWriter::fileWithRelativePath(
 	return std::make_unique<Wrap>(
 		pathWithRelativePath(path),
 		_settings.path,
-		_stats);
+		_stats,
+		_settings.outputBufferSize);
 }
 
 HtmlWriter::~HtmlWriter() = default;
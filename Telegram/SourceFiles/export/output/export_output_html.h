@@ -69,6 +69,10 @@ public:
 	Result writeDialogStart(const Data::DialogInfo &data) override;
 	Result writeDialogSlice(const Data::MessagesSlice &data) override;
 	Result writeDialogEnd() override;
+	bool canWriteFinishedDialog() override;
+	Result writeFinishedDialog(
+		const Data::DialogInfo &data,
+		int messagesCount) override;
 	Result writeDialogsEnd() override;
 
 	Result finish() override;
@@ -106,6 +110,7 @@ private:
 	[[nodiscard]] Result writeWebSessions(const Data::SessionsList &data);
 
 	[[nodiscard]] Result validateDialogsMode(bool isLeftChannel);
+	[[nodiscard]] Result writeDialogListEntry();
 	[[nodiscard]] Result writeDialogOpening(int index);
 	[[nodiscard]] Result switchToNextChatFile(int index);
 	[[nodiscard]] Result writeEmptySinglePeer();
@@ -160,6 +165,7 @@ private:
 	std::unique_ptr<Wrap> _chat;
 	std::vector<int> _lastMessageIdsPerFile;
 	bool _chatFileEmpty = false;
+	QByteArray _sliceBlock;
 
 };
 
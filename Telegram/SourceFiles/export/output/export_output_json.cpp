@@ -23,16 +23,46 @@ namespace {
 
 using Context = details::JsonContext;
 
+constexpr auto kSliceBlockReserve = 256 * 1024;
+
+[[nodiscard]] inline bool NeedsEscape(char ch) {
+	return (ch >= 0 && ch < 32)
+		|| (ch == '"')
+		|| (ch == '\\')
+		|| (ch == char(0xE2));
+}
+
 QByteArray SerializeString(const QByteArray &value) {
 	const auto size = value.size();
 	const auto begin = value.data();
 	const auto end = begin + size;
 
+	// Most of the strings don't need escaping at all,
+	// so the text between escaped characters is copied in one piece.
 	auto result = QByteArray();
-	result.reserve(2 + size * 4);
+	result.reserve(2 + size + (size >> 4));
 	result.append('"');
+	auto from = begin;
 	for (auto p = begin; p != end; ++p) {
 		const auto ch = *p;
+		if (!NeedsEscape(ch)) {
+			continue;
+		} else if (ch == char(0xE2)) {
+			if (p + 2 >= end
+				|| *(p + 1) != char(0x80)
+				|| (*(p + 2) != char(0xA8) && *(p + 2) != char(0xA9))) {
+				continue;
+			}
+			result.append(from, p - from);
+			result.append((*(p + 2) == char(0xA8))
+				? "\\u2028" // Line separator.
+				: "\\u2029", 6); // Paragraph separator.
+			p += 2;
+			from = p + 1;
+			continue;
+		}
+		result.append(from, p - from);
+		from = p + 1;
 		if (ch == '\n') {
 			result.append("\\n", 2);
 		} else if (ch == '\r') {
@@ -43,7 +73,7 @@ QByteArray SerializeString(const QByteArray &value) {
 			result.append("\\\"", 2);
 		} else if (ch == '\\') {
 			result.append("\\\\", 2);
-		} else if (ch >= 0 && ch < 32) {
+		} else {
 			result.append("\\x", 2).append('0' + (ch >> 4));
 			const auto left = (ch & 0x0F);
 			if (left >= 10) {
@@ -51,20 +81,9 @@ QByteArray SerializeString(const QByteArray &value) {
 			} else {
 				result.append('0' + left);
 			}
-		} else if (ch == char(0xE2)
-			&& (p + 2 < end)
-			&& *(p + 1) == char(0x80)) {
-			if (*(p + 2) == char(0xA8)) { // Line separator.
-				result.append("\\u2028", 6);
-			} else if (*(p + 2) == char(0xA9)) { // Paragraph separator.
-				result.append("\\u2029", 6);
-			} else {
-				result.append(ch);
-			}
-		} else {
-			result.append(ch);
 		}
 	}
+	result.append(from, end - from);
 	result.append('"');
 	return result;
 }
@@ -99,8 +118,16 @@ QByteArray SerializeObject(
 	const auto guard = gsl::finally([&] { context.nesting.pop_back(); });
 	const auto next = '\n' + Indentation(context);
 
+	auto size = 3 + indent.size();
+	for (const auto &[key, value] : values) {
+		if (!value.isEmpty()) {
+			size += next.size() + key.size() + value.size() + 5;
+		}
+	}
+
 	auto first = true;
 	auto result = QByteArray();
+	result.reserve(size);
 	result.append('{');
 	for (const auto &[key, value] : values) {
 		if (value.isEmpty()) {
@@ -111,7 +138,9 @@ QByteArray SerializeObject(
 		} else {
 			result.append(',');
 		}
-		result.append(next).append(SerializeString(key)).append(": ", 2);
+
+		// Keys are plain identifiers, they never need escaping.
+		result.append(next).append('"').append(key).append("\": ", 3);
 		result.append(value);
 	}
 	result.append('\n').append(indent).append("}");
@@ -124,8 +153,14 @@ QByteArray SerializeArray(
 	const auto indent = Indentation(context.nesting.size());
 	const auto next = '\n' + Indentation(context.nesting.size() + 1);
 
+	auto size = 3 + indent.size();
+	for (const auto &value : values) {
+		size += next.size() + value.size() + 1;
+	}
+
 	auto first = true;
 	auto result = QByteArray();
+	result.reserve(size);
 	result.append('[');
 	for (const auto &value : values) {
 		if (first) {
@@ -1065,12 +1100,16 @@ Result JsonWriter::validateDialogsMode(bool isLeftChannel) {
 Result JsonWriter::writeDialogSlice(const Data::MessagesSlice &data) {
 	Expects(_output != nullptr);
 
-	auto block = QByteArray();
+	// The buffer keeps its capacity between the slices.
+	auto &block = _sliceBlock;
+	block.reserve(kSliceBlockReserve);
+	block.resize(0);
 	for (const auto &message : data.list) {
 		if (Data::SkipMessageByDate(message, _settings)) {
 			continue;
 		}
-		block.append(prepareArrayItemStart() + SerializeMessage(
+		block.append(prepareArrayItemStart());
+		block.append(SerializeMessage(
 			_context,
 			message,
 			data.peers,
@@ -1086,6 +1125,17 @@ Result JsonWriter::writeDialogEnd() {
 	return _output->writeBlock(block + popNesting());
 }
 
+bool JsonWriter::canWriteFinishedDialog() {
+	// All the chats are written to one file.
+	return false;
+}
+
+Result JsonWriter::writeFinishedDialog(
+		const Data::DialogInfo &data,
+		int messagesCount) {
+	Unexpected("JsonWriter::writeFinishedDialog.");
+}
+
 Result JsonWriter::writeDialogsEnd() {
 	if (_settings.onlySinglePeer()) {
 		return Result::Success();
@@ -1118,11 +1168,14 @@ Result JsonWriter::finish() {
 
 	if (_settings.onlySinglePeer()) {
 		Assert(_context.nesting.empty());
-		return Result::Success();
+		return _output->flush();
 	}
 	auto block = popNesting();
 	Assert(_context.nesting.empty());
-	return _output->writeBlock(block);
+	if (const auto result = _output->writeBlock(block); !result) {
+		return result;
+	}
+	return _output->flush();
 }
 
 QString JsonWriter::mainFilePath() {
@@ -1139,7 +1192,10 @@ QString JsonWriter::pathWithRelativePath(const QString &path) const {
 
 std::unique_ptr<File> JsonWriter::fileWithRelativePath(
 		const QString &path) const {
-	return std::make_unique<File>(pathWithRelativePath(path), _stats);
+	return std::make_unique<File>(
+		pathWithRelativePath(path),
+		_stats,
+		_settings.outputBufferSize);
 }
 
 } // namespace Output
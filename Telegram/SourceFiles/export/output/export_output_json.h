@@ -54,6 +54,10 @@ public:
 	Result writeDialogStart(const Data::DialogInfo &data) override;
 	Result writeDialogSlice(const Data::MessagesSlice &data) override;
 	Result writeDialogEnd() override;
+	bool canWriteFinishedDialog() override;
+	Result writeFinishedDialog(
+		const Data::DialogInfo &data,
+		int messagesCount) override;
 	Result writeDialogsEnd() override;
 
 	Result finish() override;
@@ -96,6 +100,7 @@ private:
 
 	Context _context;
 	bool _currentNestingHadItem = false;
+	QByteArray _sliceBlock;
 	DialogsMode _dialogsMode = DialogsMode::None;
 
 	std::unique_ptr<File> _output;
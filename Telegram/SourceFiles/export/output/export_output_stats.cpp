@@ -12,7 +12,8 @@ namespace Output {
 
 Stats::Stats(const Stats &other)
 : _files(other._files.load())
-, _bytes(other._bytes.load()) {
+, _bytes(other._bytes.load())
+, _writes(other._writes.load()) {
 }
 
 void Stats::incrementFiles() {
@@ -23,6 +24,10 @@ void Stats::incrementBytes(int count) {
 	_bytes += count;
 }
 
+void Stats::incrementWrites() {
+	++_writes;
+}
+
 int Stats::filesCount() const {
 	return _files;
 }
@@ -31,5 +36,9 @@ int64 Stats::bytesCount() const {
 	return _bytes;
 }
 
+int64 Stats::writesCount() const {
+	return _writes;
+}
+
 } // namespace Output
 } // namespace Export
@@ -19,13 +19,18 @@ public:
 
 	void incrementFiles();
 	void incrementBytes(int count);
+	void incrementWrites();
 
 	int filesCount() const;
 	int64 bytesCount() const;
 
+	// How many times the buffered bytes were written to the disk.
+	int64 writesCount() const;
+
 private:
 	std::atomic<int> _files;
 	std::atomic<int64> _bytes;
+	std::atomic<int64> _writes;
 
 };
 
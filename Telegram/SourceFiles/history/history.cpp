@@ -10,6 +10,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/view/history_view_element.h"
 #include "history/history_message.h"
 #include "history/history_service.h"
+#include "history/view/history_view_message.h"
+#include "history/view/history_view_service_message.h"
 #include "history/history_item_components.h"
 #include "history/history_inner_widget.h"
 #include "dialogs/dialogs_indexed_list.h"
@@ -39,6 +41,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/storage_facade.h"
 #include "storage/storage_shared_media.h"
 #include "storage/storage_account.h"
+#include "storage/storage_messages_index.h"
+#include "storage/storage_messages_cache.h"
 //#include "storage/storage_feed_messages.h" // #feed
 #include "support/support_helper.h"
 #include "ui/image/image.h"
@@ -51,6 +55,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace {
 
 constexpr auto kNewBlockEachMessage = 50;
+constexpr auto kUnloadBlocksViewsCount = 1500;
+constexpr auto kKeepLoadedViewsCount = 1000;
 constexpr auto kSkipCloudDraftsFor = TimeId(3);
 
 using UpdateFlag = Data::HistoryUpdate::Flag;
@@ -453,6 +459,9 @@ not_null<HistoryItem*> History::addNewItem(
 	} else if (!item->isHistoryEntry()) {
 		return item;
 	}
+	if (unread) {
+		owner().messagesIndex().add(item);
+	}
 	if (!loadedAtBottom() || peer->migrateTo()) {
 		setLastMessage(item);
 		if (unread) {
@@ -1181,6 +1190,7 @@ void History::addOlderSlice(const QVector<MTPMessage> &slice) {
 			addItemsToLists(added);
 		}
 		addToSharedMedia(added);
+		owner().messagesIndex().add(added);
 	} else {
 		// If no items were added it means we've loaded everything old.
 		_loadedAtTop = true;
@@ -1191,6 +1201,43 @@ void History::addOlderSlice(const QVector<MTPMessage> &slice) {
 	checkLastMessage();
 }
 
+void History::addCachedSlice(const QVector<MTPMessage> &slice) {
+	Expects(isEmpty());
+
+	if (const auto added = createItems(slice); !added.empty()) {
+		startBuildingFrontBlock(added.size());
+		for (const auto item : added) {
+			addItemToBlock(item);
+		}
+		finishBuildingFrontBlock();
+	}
+}
+
+void History::dropUnconfirmedCachedItems(
+		const base::flat_set<MsgId> &cachedIds,
+		const QVector<MTPMessage> &slice) {
+	auto confirmed = base::flat_set<MsgId>();
+	auto minConfirmedId = MsgId(0);
+	for (const auto &message : slice) {
+		const auto id = IdFromMessage(message);
+		confirmed.emplace(id);
+		if (!minConfirmedId || id < minConfirmedId) {
+			minConfirmedId = id;
+		}
+	}
+	for (const auto id : cachedIds) {
+		if (confirmed.contains(id)) {
+			continue;
+		}
+		const auto item = owner().message(channelId(), id);
+		if (!item || item->history() != this) {
+			continue;
+		} else if (id > minConfirmedId || loadedAtTop()) {
+			item->destroy();
+		}
+	}
+}
+
 void History::addNewerSlice(const QVector<MTPMessage> &slice) {
 	bool wasEmpty = isEmpty(), wasLoadedAtBottom = loadedAtBottom();
 
@@ -1209,6 +1256,7 @@ void History::addNewerSlice(const QVector<MTPMessage> &slice) {
 		}
 
 		addToSharedMedia(added);
+		owner().messagesIndex().add(added);
 	} else {
 		_loadedAtBottom = true;
 		setLastMessage(lastAvailableMessage());
@@ -2668,23 +2716,54 @@ HistoryItem *History::lastSentMessage() const {
 	return nullptr;
 }
 
-void History::resizeToWidth(int newWidth) {
+void History::resizeToWidth(int newWidth, int layoutFrom, int layoutTill) {
 	const auto resizeAllItems = (_width != newWidth);
 
 	if (!resizeAllItems && !hasPendingResizedItems()) {
 		return;
 	}
-	_flags &= ~(Flag::f_has_pending_resized_items);
+	_flags &= ~(Flag::f_has_pending_resized_items
+		| Flag::f_has_estimated_heights);
 
 	_width = newWidth;
 	int y = 0;
 	for (const auto &block : blocks) {
+		const auto top = block->y();
 		block->setY(y);
-		y += block->resizeGetHeight(newWidth, resizeAllItems);
+		y += block->resizeGetHeight(
+			newWidth,
+			resizeAllItems,
+			layoutFrom - top,
+			layoutTill - top);
 	}
 	_height = y;
 }
 
+void History::requestEstimatedLayout(int from, int till) {
+	if (!(_flags & Flag::f_has_estimated_heights)
+		|| hasPendingResizedItems()) {
+		return;
+	}
+	for (const auto &block : blocks) {
+		const auto top = block->y();
+		if (top >= till) {
+			break;
+		} else if (top + block->height() <= from) {
+			continue;
+		}
+		for (const auto &message : block->messages) {
+			const auto itemTop = top + message->y();
+			if (itemTop >= till) {
+				break;
+			} else if (message->heightEstimated()
+				&& itemTop + message->height() > from) {
+				setHasPendingResizedItems();
+				return;
+			}
+		}
+	}
+}
+
 void History::forceFullResize() {
 	_width = 0;
 	_flags |= Flag::f_has_pending_resized_items;
@@ -2994,6 +3073,7 @@ void History::clear(ClearType type) {
 		}
 		_notifications.clear();
 		owner().notifyHistoryCleared(this);
+		owner().messagesCache().remove(this);
 		if (unreadCountKnown()) {
 			setUnreadCount(0);
 		}
@@ -3055,6 +3135,106 @@ void History::clearUpTill(MsgId availableMinId) {
 	requestChatListMessage();
 }
 
+bool History::unloadFarBlocks(
+		int from,
+		int till,
+		bool fromTop,
+		bool fromBottom) {
+	if (isBuildingFrontBlock()) {
+		return false;
+	}
+	auto count = loadedViewsCount();
+	if (count <= kUnloadBlocksViewsCount) {
+		return false;
+	}
+	auto unloaded = false;
+	while (count > kKeepLoadedViewsCount && blocks.size() > 1) {
+		const auto first = blocks.front().get();
+		const auto last = blocks.back().get();
+		const auto above = (fromTop && canUnloadBlock(first))
+			? (from - first->y() - first->height())
+			: -1;
+		const auto below = (fromBottom && canUnloadBlock(last))
+			? (last->y() - till)
+			: -1;
+		if (above < 0 && below < 0) {
+			break;
+		}
+		const auto block = (above >= below) ? first : last;
+		count -= int(block->messages.size());
+		unloadBlock(block);
+		unloaded = true;
+	}
+	if (unloaded) {
+		owner().notifyHistoryChangeDelayed(this);
+	}
+	return unloaded;
+}
+
+void History::unloadBlocks() {
+	clear(ClearType::Unload);
+}
+
+int History::loadedViewsCount() const {
+	auto result = 0;
+	for (const auto &block : blocks) {
+		result += int(block->messages.size());
+	}
+	return result;
+}
+
+History::MemoryReport History::memoryReport() const {
+	auto result = MemoryReport();
+	for (const auto &item : _messages) {
+		if (item->toHistoryMessage()) {
+			++result.messages;
+			result.bytes += sizeof(HistoryMessage);
+		} else {
+			++result.services;
+			result.bytes += sizeof(HistoryService);
+		}
+	}
+	for (const auto &block : blocks) {
+		++result.blocks;
+		result.bytes += sizeof(HistoryBlock);
+		for (const auto &message : block->messages) {
+			++result.views;
+			result.bytes += message->data()->toHistoryMessage()
+				? sizeof(HistoryView::Message)
+				: sizeof(HistoryView::Service);
+		}
+	}
+	return result;
+}
+
+bool History::canUnloadBlock(not_null<HistoryBlock*> block) const {
+	const auto inBlock = [&](Element *view) {
+		return view && (view->block() == block);
+	};
+	return !inBlock(_joinedMessage ? _joinedMessage->mainView() : nullptr)
+		&& !inBlock(_firstUnreadView)
+		&& !inBlock(_unreadBarView)
+		&& !inBlock(scrollTopItem);
+}
+
+void History::unloadBlock(not_null<HistoryBlock*> block) {
+	Expects(!isBuildingFrontBlock());
+
+	const auto front = (block->indexInHistory() == 0);
+	for (const auto &message : block->messages) {
+		message->data()->clearMainView();
+	}
+	base::take(block->messages);
+
+	// Deletes the block.
+	removeBlock(block);
+	if (front) {
+		_loadedAtTop = false;
+	} else {
+		_loadedAtBottom = false;
+	}
+}
+
 void History::applyGroupAdminChanges(const base::flat_set<UserId> &changes) {
 	for (const auto &block : blocks) {
 		for (const auto &message : block->messages) {
@@ -3092,16 +3272,33 @@ HistoryBlock::HistoryBlock(not_null<History*> history)
 : _history(history) {
 }
 
-int HistoryBlock::resizeGetHeight(int newWidth, bool resizeAllItems) {
+int HistoryBlock::resizeGetHeight(
+		int newWidth,
+		bool resizeAllItems,
+		int layoutFrom,
+		int layoutTill) {
 	auto y = 0;
+	auto estimated = false;
 	for (const auto &message : messages) {
+		const auto top = message->y();
+		const auto near = (top < layoutTill)
+			&& (top + message->height() > layoutFrom);
 		message->setY(y);
-		if (resizeAllItems || message->pendingResize()) {
+		if (message->pendingResize()
+			|| ((resizeAllItems || message->heightEstimated())
+				&& (near || !message->width()))) {
 			y += message->resizeGetHeight(newWidth);
 		} else {
+			if (resizeAllItems) {
+				message->setHeightEstimated();
+			}
+			estimated = estimated || message->heightEstimated();
 			y += message->height();
 		}
 	}
+	if (estimated) {
+		_history->_flags |= History::Flag::f_has_estimated_heights;
+	}
 	_height = y;
 	return _height;
 }
@@ -92,6 +92,25 @@ public:
 	void clear(ClearType type);
 	void clearUpTill(MsgId availableMinId);
 
+	// Whole blocks far from [from, till) are unloaded when too many views
+	// are loaded, they are loaded back by the usual slice requests.
+	bool unloadFarBlocks(int from, int till, bool fromTop, bool fromBottom);
+
+	// Unloads all blocks, the history can be loaded from the server again.
+	// The messages are kept, raw pointers to them are held in many places
+	// that are cleared only when the message is destroyed.
+	void unloadBlocks();
+	[[nodiscard]] int loadedViewsCount() const;
+
+	struct MemoryReport {
+		int messages = 0;
+		int services = 0;
+		int views = 0;
+		int blocks = 0;
+		int64 bytes = 0;
+	};
+	[[nodiscard]] MemoryReport memoryReport() const;
+
 	void applyGroupAdminChanges(const base::flat_set<UserId> &changes);
 
 	template <typename ...Args>
@@ -175,6 +194,17 @@ public:
 	void addOlderSlice(const QVector<MTPMessage> &slice);
 	void addNewerSlice(const QVector<MTPMessage> &slice);
 
+	// Shows a locally cached slice while the server one is loading.
+	// It doesn't mark any edges as loaded and doesn't touch shared media.
+	void addCachedSlice(const QVector<MTPMessage> &slice);
+
+	// Destroys the cached items in the range the first server slice covers
+	// that it didn't return, they were deleted. The older ones are kept
+	// until the slice with them is loaded.
+	void dropUnconfirmedCachedItems(
+		const base::flat_set<MsgId> &cachedIds,
+		const QVector<MTPMessage> &slice);
+
 	void newItemAdded(not_null<HistoryItem*> item);
 
 	void registerLocalMessage(not_null<HistoryItem*> item);
@@ -258,8 +288,11 @@ public:
 	MsgId msgIdForRead() const;
 	HistoryItem *lastSentMessage() const;
 
-	void resizeToWidth(int newWidth);
+	// Only items between layoutFrom and layoutTill (in the current
+	// coordinates) are laid out, others keep their heights as estimates.
+	void resizeToWidth(int newWidth, int layoutFrom, int layoutTill);
 	void forceFullResize();
+	void requestEstimatedLayout(int from, int till);
 	int height() const;
 
 	void itemRemoved(not_null<HistoryItem*> item);
@@ -409,6 +442,7 @@ private:
 
 	enum class Flag {
 		f_has_pending_resized_items = (1 << 0),
+		f_has_estimated_heights = (1 << 1),
 	};
 	using Flags = base::flags<Flag>;
 	friend inline constexpr auto is_flag_type(Flag) {
@@ -430,6 +464,9 @@ private:
 	void removeBlock(not_null<HistoryBlock*> block);
 	void clearSharedMedia();
 
+	[[nodiscard]] bool canUnloadBlock(not_null<HistoryBlock*> block) const;
+	void unloadBlock(not_null<HistoryBlock*> block);
+
 	not_null<HistoryItem*> insertItem(std::unique_ptr<HistoryItem> item);
 	not_null<HistoryItem*> addNewItem(
 		not_null<HistoryItem*> item,
@@ -585,7 +622,11 @@ public:
 	void remove(not_null<Element*> view);
 	void refreshView(not_null<Element*> view);
 
-	int resizeGetHeight(int newWidth, bool resizeAllItems);
+	int resizeGetHeight(
+		int newWidth,
+		bool resizeAllItems,
+		int layoutFrom,
+		int layoutTill);
 	int y() const {
 		return _y;
 	}
@@ -72,6 +72,7 @@ namespace {
 
 constexpr auto kScrollDateHideTimeout = 1000;
 constexpr auto kUnloadHeavyPartsPages = 2;
+constexpr auto kLayoutAroundPages = 1;
 constexpr auto kClearUserpicsAfter = 50;
 
 // Helper binary search for an item in a list that is not completely
@@ -2110,9 +2111,22 @@ void HistoryInner::recountHistoryGeometry() {
 		accumulate_max(oldHistoryPaddingTop, st::msgMargin.top() + st::msgMargin.bottom() + st::msgPadding.top() + st::msgPadding.bottom() + st::msgNameFont->height + st::botDescSkip + _botAbout->height);
 	}
 
-	_history->resizeToWidth(_contentWidth);
+	// Lay out only items around the visible area, using the
+	// coordinates from the previous layout.
+	const auto layoutSkip = kLayoutAroundPages * visibleHeight;
+	const auto layoutFrom = _visibleAreaTop - layoutSkip;
+	const auto layoutTill = _visibleAreaBottom + layoutSkip;
+	const auto historyTopWas = historyTop();
+	const auto migratedTopWas = migratedTop();
+	_history->resizeToWidth(
+		_contentWidth,
+		layoutFrom - historyTopWas,
+		layoutTill - historyTopWas);
 	if (_migrated) {
-		_migrated->resizeToWidth(_contentWidth);
+		_migrated->resizeToWidth(
+			_contentWidth,
+			layoutFrom - migratedTopWas,
+			layoutTill - migratedTopWas);
 	}
 
 	// With migrated history we perhaps do not need to display
@@ -2278,11 +2292,32 @@ void HistoryInner::visibleAreaUpdated(int top, int bottom) {
 		_userpicsCache = std::move(_userpics);
 	}
 
+	// Lay out items with estimated heights that come near.
+	const auto layoutSkip = kLayoutAroundPages * visibleAreaHeight;
+	if (const auto htop = historyTop(); htop >= 0) {
+		_history->requestEstimatedLayout(
+			top - layoutSkip - htop,
+			bottom + layoutSkip - htop);
+	}
+	if (const auto mtop = migratedTop(); mtop >= 0) {
+		_migrated->requestEstimatedLayout(
+			top - layoutSkip - mtop,
+			bottom + layoutSkip - mtop);
+	}
+
 	// Unload lottie animations.
 	const auto pages = kUnloadHeavyPartsPages;
 	const auto from = _visibleAreaTop - pages * visibleAreaHeight;
 	const auto till = _visibleAreaBottom + pages * visibleAreaHeight;
 	session().data().unloadHeavyViewParts(ElementDelegate(), from, till);
+
+	// Unload far blocks, keeping the migrated and history junction.
+	if (const auto htop = historyTop(); htop >= 0) {
+		_history->unloadFarBlocks(from - htop, till - htop, !_migrated, true);
+	}
+	if (const auto mtop = migratedTop(); mtop >= 0) {
+		_migrated->unloadFarBlocks(from - mtop, till - mtop, true, false);
+	}
 	checkHistoryActivation();
 }
 
@@ -13,6 +13,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/view/history_view_element.h"
 #include "history/view/history_view_service_message.h"
 #include "history/history_item_components.h"
+#include "history/history_memory_pool.h"
 #include "history/view/media/history_view_media_grouped.h"
 #include "history/history_service.h"
 #include "history/history_message.h"
@@ -909,6 +910,14 @@ void HistoryItem::drawInDialog(
 
 HistoryItem::~HistoryItem() = default;
 
+void *HistoryItem::operator new(std::size_t size) {
+	return HistoryView::ItemsMemoryPool().allocate(size);
+}
+
+void HistoryItem::operator delete(void *pointer, std::size_t size) {
+	HistoryView::ItemsMemoryPool().deallocate(pointer, size);
+}
+
 QDateTime ItemDateTime(not_null<const HistoryItem*> item) {
 	return base::unixtime::parse(item->date());
 }
@@ -391,6 +391,10 @@ public:
 
 	virtual ~HistoryItem();
 
+	// Items are allocated from HistoryView::ItemsMemoryPool().
+	static void *operator new(std::size_t size);
+	static void operator delete(void *pointer, std::size_t size);
+
 	MsgId id;
 
 protected:
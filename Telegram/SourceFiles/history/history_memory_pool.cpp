@@ -0,0 +1,64 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "history/history_memory_pool.h"
+
+namespace HistoryView {
+
+int MemoryPool::sizeClass(std::size_t size) {
+	return int((size + kAlignment - 1) / kAlignment) - 1;
+}
+
+void *MemoryPool::allocate(std::size_t size) {
+	if (!size || size > kMaxPooledSize) {
+		return ::operator new(size);
+	}
+	const auto index = sizeClass(size);
+	const auto rounded = (index + 1) * kAlignment;
+	++_stats.objects;
+	_stats.used += rounded;
+	if (const auto entry = _free[index]) {
+		_free[index] = entry->next;
+		return entry;
+	}
+	if (_chunkEnd - _chunkPosition < std::ptrdiff_t(rounded)) {
+		_chunks.push_back(std::make_unique<std::byte[]>(kChunkSize));
+		_chunkPosition = _chunks.back().get();
+		_chunkEnd = _chunkPosition + kChunkSize;
+		_stats.reserved += kChunkSize;
+	}
+	return std::exchange(_chunkPosition, _chunkPosition + rounded);
+}
+
+void MemoryPool::deallocate(void *pointer, std::size_t size) {
+	if (!pointer) {
+		return;
+	} else if (!size || size > kMaxPooledSize) {
+		::operator delete(pointer);
+		return;
+	}
+	const auto index = sizeClass(size);
+	--_stats.objects;
+	_stats.used -= (index + 1) * kAlignment;
+	_free[index] = new (pointer) FreeEntry{ _free[index] };
+}
+
+MemoryPool::Stats MemoryPool::stats() const {
+	return _stats;
+}
+
+MemoryPool &ItemsMemoryPool() {
+	static auto result = MemoryPool();
+	return result;
+}
+
+MemoryPool &ViewsMemoryPool() {
+	static auto result = MemoryPool();
+	return result;
+}
+
+} // namespace HistoryView
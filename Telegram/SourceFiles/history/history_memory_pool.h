@@ -0,0 +1,54 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace HistoryView {
+
+// Hands out small objects of same size classes from large chunks, so that
+// many messages and views don't fragment the heap. Main thread only.
+class MemoryPool final {
+public:
+	MemoryPool() = default;
+	MemoryPool(const MemoryPool &other) = delete;
+	MemoryPool &operator=(const MemoryPool &other) = delete;
+
+	struct Stats {
+		int64 reserved = 0;
+		int64 used = 0;
+		int objects = 0;
+	};
+
+	[[nodiscard]] void *allocate(std::size_t size);
+	void deallocate(void *pointer, std::size_t size);
+
+	[[nodiscard]] Stats stats() const;
+
+private:
+	struct FreeEntry {
+		FreeEntry *next = nullptr;
+	};
+
+	static constexpr auto kAlignment = std::size_t(16);
+	static constexpr auto kMaxPooledSize = std::size_t(1024);
+	static constexpr auto kClassesCount = kMaxPooledSize / kAlignment;
+	static constexpr auto kChunkSize = std::size_t(64 * 1024);
+
+	[[nodiscard]] static int sizeClass(std::size_t size);
+
+	std::array<FreeEntry*, kClassesCount> _free = { { nullptr } };
+	std::vector<std::unique_ptr<std::byte[]>> _chunks;
+	std::byte *_chunkPosition = nullptr;
+	std::byte *_chunkEnd = nullptr;
+	Stats _stats;
+
+};
+
+[[nodiscard]] MemoryPool &ItemsMemoryPool();
+[[nodiscard]] MemoryPool &ViewsMemoryPool();
+
+} // namespace HistoryView
@@ -81,6 +81,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/storage_account.h"
 #include "storage/file_upload.h"
 #include "storage/storage_media_prepare.h"
+#include "storage/storage_messages_cache.h"
 #include "media/audio/media_audio.h"
 #include "media/audio/media_audio_capture.h"
 #include "media/player/media_player_instance.h"
@@ -1777,6 +1778,7 @@ void HistoryWidget::showHistory(
 			_migrated->clear(History::ClearType::Unload);
 		}
 		_history->setFakeUnreadWhileOpened(true);
+		session().data().historyShown(_history);
 
 		_topBar->setActiveChat(
 			_history,
@@ -1914,6 +1916,11 @@ void HistoryWidget::clearAllLoadRequests() {
 		histories.cancelRequest(_firstLoadRequest);
 		_firstLoadRequest = 0;
 	}
+	if (_cachedSliceRequest) {
+		histories.cancelRequest(_cachedSliceRequest);
+		_cachedSliceRequest = 0;
+	}
+	_cachedSliceIds.clear();
 	if (_preloadRequest) {
 		histories.cancelRequest(_preloadRequest);
 		_preloadRequest = 0;
@@ -2327,6 +2334,10 @@ void HistoryWidget::messagesFailed(const RPCError &error, int requestId) {
 	} else if (_firstLoadRequest == requestId) {
 		_firstLoadRequest = 0;
 		controller()->showBackFromStack();
+	} else if (_cachedSliceRequest == requestId) {
+		// Leave the cached slice shown, but allow loading from now on.
+		_cachedSliceRequest = 0;
+		_cachedSliceIds.clear();
 	} else if (_delayedShowAtRequest == requestId) {
 		_delayedShowAtRequest = 0;
 	}
@@ -2343,6 +2354,8 @@ void HistoryWidget::messagesReceived(PeerData *peer, const MTPmessages_Messages
 			_preloadDownRequest = 0;
 		} else if (_firstLoadRequest == requestId) {
 			_firstLoadRequest = 0;
+		} else if (_cachedSliceRequest == requestId) {
+			_cachedSliceRequest = 0;
 		} else if (_delayedShowAtRequest == requestId) {
 			_delayedShowAtRequest = 0;
 		}
@@ -2426,6 +2439,29 @@ void HistoryWidget::messagesReceived(PeerData *peer, const MTPmessages_Messages
 			return;
 		}
 
+		historyLoaded();
+	} else if (_cachedSliceRequest == requestId) {
+		_cachedSliceRequest = 0;
+
+		// Replace the cached slice with the server one, updating the
+		// cached items that could've been edited since they were saved.
+		_firstLoadRequest = -1; // hack - don't updateListSize yet
+		_history->clear(History::ClearType::Unload);
+		for (const auto &message : *histList) {
+			if (_cachedSliceIds.contains(IdFromMessage(message))) {
+				_history->owner().updateEditedMessage(message);
+			}
+		}
+		addMessagesToFront(peer, *histList);
+		_history->dropUnconfirmedCachedItems(
+			base::take(_cachedSliceIds),
+			*histList);
+		_firstLoadRequest = 0;
+		if (_history->loadedAtTop() && _history->isEmpty() && count > 0) {
+			firstLoadMessages();
+			return;
+		}
+
 		historyLoaded();
 	} else if (_delayedShowAtRequest == requestId) {
 		if (toMigrated) {
@@ -2484,6 +2520,7 @@ bool HistoryWidget::doWeReadMentions() const {
 		&& _list
 		&& _historyInited
 		&& !_firstLoadRequest
+		&& !_cachedSliceRequest
 		&& !_delayedShowAtRequest
 		&& !_a_show.animating()
 		&& controller()->widget()->doWeMarkAsRead();
@@ -2504,6 +2541,7 @@ void HistoryWidget::firstLoadMessages() {
 	auto offsetId = 0;
 	auto offset = 0;
 	auto loadCount = kMessagesPerPage;
+	auto cacheSlice = false;
 	if (_showAtMsgId == ShowAtUnreadMsgId) {
 		if (const auto around = _migrated ? _migrated->loadAroundId() : 0) {
 			_history->getReadyFor(_showAtMsgId);
@@ -2516,10 +2554,12 @@ void HistoryWidget::firstLoadMessages() {
 			offsetId = around;
 		} else {
 			_history->getReadyFor(ShowAtTheEndMsgId);
+			cacheSlice = true;
 		}
 	} else if (_showAtMsgId == ShowAtTheEndMsgId) {
 		_history->getReadyFor(_showAtMsgId);
 		loadCount = kMessagesPerPageFirst;
+		cacheSlice = true;
 	} else if (_showAtMsgId > 0) {
 		_history->getReadyFor(_showAtMsgId);
 		offset = -loadCount / 2;
@@ -2554,13 +2594,56 @@ void HistoryWidget::firstLoadMessages() {
 			MTP_int(minId),
 			MTP_int(historyHash)
 		)).done([=](const MTPmessages_Messages &result) {
-			messagesReceived(history->peer, result, _firstLoadRequest);
+			if (cacheSlice) {
+				history->owner().messagesCache().put(history, result);
+			}
+			messagesReceived(
+				history->peer,
+				result,
+				_firstLoadRequest ? _firstLoadRequest : _cachedSliceRequest);
 			finish();
 		}).fail([=](const RPCError &error) {
-			messagesFailed(error, _firstLoadRequest);
+			messagesFailed(
+				error,
+				_firstLoadRequest ? _firstLoadRequest : _cachedSliceRequest);
 			finish();
 		}).send();
 	});
+	if (cacheSlice && _history->isEmpty()) {
+		const auto requestId = _firstLoadRequest;
+		history->owner().messagesCache().get(history, crl::guard(this, [=](
+				const MTPmessages_Messages &result) {
+			cachedMessagesReceived(history, result, requestId);
+		}));
+	}
+}
+
+void HistoryWidget::cachedMessagesReceived(
+		not_null<History*> history,
+		const MTPmessages_Messages &messages,
+		int requestId) {
+	if (_history != history
+		|| _firstLoadRequest != requestId
+		|| !_history->isEmpty()) {
+		return;
+	}
+	const auto &data = messages.c_messages_messages();
+	const auto &list = data.vmessages().v;
+	if (list.isEmpty()) {
+		return;
+	}
+	_history->owner().processUsers(data.vusers());
+	_history->owner().processChats(data.vchats());
+
+	// Show the cached slice and wait for the server one in a separate
+	// request id, so that the widget works as if the history was loaded.
+	_cachedSliceRequest = base::take(_firstLoadRequest);
+	_cachedSliceIds.clear();
+	for (const auto &message : list) {
+		_cachedSliceIds.emplace(IdFromMessage(message));
+	}
+	_history->addCachedSlice(list);
+	historyLoaded();
 }
 
 void HistoryWidget::loadMessages() {
@@ -2758,6 +2841,12 @@ void HistoryWidget::visibleAreaUpdated() {
 		const auto scrollTop = _scroll->scrollTop();
 		const auto scrollBottom = scrollTop + _scroll->height();
 		_list->visibleAreaUpdated(scrollTop, scrollBottom);
+		if (hasPendingResizedItems()) {
+			// Items with estimated heights came near the visible area.
+			crl::on_main(this, [=] {
+				handlePendingHistoryUpdate();
+			});
+		}
 		controller()->floatPlayerAreaUpdated();
 	}
 }
@@ -2787,6 +2876,7 @@ void HistoryWidget::preloadHistoryIfNeeded() {
 
 void HistoryWidget::preloadHistoryByScroll() {
 	if (_firstLoadRequest
+		|| _cachedSliceRequest
 		|| _delayedShowAtRequest
 		|| _scroll->isHidden()
 		|| !_peer
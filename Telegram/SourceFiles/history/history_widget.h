@@ -527,6 +527,10 @@ private:
 	void gotPreview(QString links, const MTPMessageMedia &media, mtpRequestId req);
 	void messagesReceived(PeerData *peer, const MTPmessages_Messages &messages, int requestId);
 	void messagesFailed(const RPCError &error, int requestId);
+	void cachedMessagesReceived(
+		not_null<History*> history,
+		const MTPmessages_Messages &messages,
+		int requestId);
 	void addMessagesToFront(PeerData *peer, const QVector<MTPMessage> &messages);
 	void addMessagesToBack(PeerData *peer, const QVector<MTPMessage> &messages);
 
@@ -637,6 +641,11 @@ private:
 	MsgId _showAtMsgId = ShowAtUnreadMsgId;
 
 	int _firstLoadRequest = 0; // Not real mtpRequestId.
+
+	// First load request while a cached slice is already shown.
+	int _cachedSliceRequest = 0; // Not real mtpRequestId.
+	base::flat_set<MsgId> _cachedSliceIds;
+
 	int _preloadRequest = 0; // Not real mtpRequestId.
 	int _preloadDownRequest = 0; // Not real mtpRequestId.
 
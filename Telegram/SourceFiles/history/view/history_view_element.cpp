@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/view/history_view_element.h"
 
 #include "history/view/history_view_service_message.h"
+#include "history/history_memory_pool.h"
 #include "history/view/history_view_message.h"
 #include "history/history_item_components.h"
 #include "history/history_item.h"
@@ -324,6 +325,14 @@ bool Element::pendingResize() const {
 	return _flags & Flag::NeedsResize;
 }
 
+void Element::setHeightEstimated() {
+	_flags |= Flag::HeightEstimated;
+}
+
+bool Element::heightEstimated() const {
+	return _flags & Flag::HeightEstimated;
+}
+
 bool Element::isAttachedToPrevious() const {
 	return _flags & Flag::AttachedToPrevious;
 }
@@ -525,6 +534,7 @@ QSize Element::countOptimalSize() {
 }
 
 QSize Element::countCurrentSize(int newWidth) {
+	_flags &= ~Flag::HeightEstimated;
 	if (_flags & Flag::NeedsResize) {
 		_flags &= ~Flag::NeedsResize;
 		initDimensions();
@@ -812,4 +822,12 @@ Element::~Element() {
 	history()->owner().unregisterItemView(this);
 }
 
+void *Element::operator new(std::size_t size) {
+	return ViewsMemoryPool().allocate(size);
+}
+
+void Element::operator delete(void *pointer, std::size_t size) {
+	ViewsMemoryPool().deallocate(pointer, size);
+}
+
 } // namespace HistoryView
@@ -161,6 +161,7 @@ public:
 		AttachedToPrevious = 0x02,
 		AttachedToNext     = 0x04,
 		HiddenByGroup      = 0x08,
+		HeightEstimated    = 0x10,
 	};
 	using Flags = base::flags<Flag>;
 	friend inline constexpr auto is_flag_type(Flag) { return true; }
@@ -182,6 +183,10 @@ public:
 
 	void setPendingResize();
 	bool pendingResize() const;
+
+	// Height is kept from the layout at another width until laid out.
+	void setHeightEstimated();
+	bool heightEstimated() const;
 	bool isUnderCursor() const;
 
 	bool isLastAndSelfMessage() const;
@@ -309,6 +314,10 @@ public:
 
 	virtual ~Element();
 
+	// Views are allocated from ViewsMemoryPool().
+	static void *operator new(std::size_t size);
+	static void operator delete(void *pointer, std::size_t size);
+
 protected:
 	void paintHighlight(
 		Painter &p,
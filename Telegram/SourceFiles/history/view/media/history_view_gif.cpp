@@ -25,7 +25,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/view/history_view_cursor_state.h"
 #include "history/view/media/history_view_media_common.h"
 #include "window/window_session_controller.h"
-#include "core/application.h" // Application::showDocument.
+#include "core/application.h"
+#include "ui/effects/frame_scheduler.h"
 #include "ui/image/image.h"
 #include "ui/text/format_values.h"
 #include "ui/grouped_layout.h"
@@ -58,6 +59,7 @@ struct Gif::Streamed {
 		std::shared_ptr<::Media::Streaming::Document> shared,
 		Fn<void()> waitingCallback);
 	::Media::Streaming::Instance instance;
+	Fn<void()> repaint;
 	::Media::Streaming::FrameRequest frozenRequest;
 	QImage frozenFrame;
 	QString frozenStatusText;
@@ -1396,6 +1398,10 @@ void Gif::createStreamedPlayer() {
 		std::move(shared),
 		[=] { repaintStreamedContent(); }));
 
+	_streamed->repaint = Core::App().frameScheduler().wrap(
+		Ui::FramePriority::Chat,
+		[=] { repaintStreamedContent(); },
+		_streamed->instance.lifetime());
 	_streamed->instance.player().updates(
 	) | rpl::start_with_next_error([=](::Media::Streaming::Update &&update) {
 		handleStreamingUpdate(std::move(update));
@@ -1451,7 +1457,7 @@ void Gif::handleStreamingUpdate(::Media::Streaming::Update &&update) {
 		streamingReady(std::move(update));
 	}, [&](const PreloadedVideo &update) {
 	}, [&](const UpdateVideo &update) {
-		repaintStreamedContent();
+		_streamed->repaint();
 	}, [&](const PreloadedAudio &update) {
 	}, [&](const UpdateAudio &update) {
 	}, [&](const WaitingForData &update) {
@@ -18,6 +18,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/image/image.h"
 #include "ui/emoji_config.h"
 #include "core/application.h"
+#include "ui/effects/frame_scheduler.h"
 #include "core/core_settings.h"
 #include "main/main_session.h"
 #include "main/main_account.h"
@@ -311,12 +312,16 @@ void Sticker::lottieCreated() {
 
 	_parent->history()->owner().registerHeavyViewPart(_parent);
 
+	const auto repaint = Core::App().frameScheduler().wrap(
+		Ui::FramePriority::Chat,
+		[=] { _parent->history()->owner().requestViewRepaint(_parent); },
+		_lifetime);
 	_lottie->updates(
 	) | rpl::start_with_next([=](Lottie::Update update) {
 		v::match(update.data, [&](const Lottie::Information &information) {
 			_parent->history()->owner().requestViewResize(_parent);
 		}, [&](const Lottie::DisplayFrameRequest &request) {
-			_parent->history()->owner().requestViewRepaint(_parent);
+			repaint();
 		});
 	}, _lifetime);
 }
@@ -338,6 +343,7 @@ void Sticker::unloadLottie() {
 		_nextLastDiceFrame = false;
 		_lottieOncePlayed = false;
 	}
+	_lifetime.destroy();
 	_lottie = nullptr;
 	_parent->checkHeavyPart();
 }
@@ -345,9 +351,11 @@ void Sticker::unloadLottie() {
 std::unique_ptr<Lottie::SinglePlayer> Sticker::stickerTakeLottie(
 		not_null<DocumentData*> data,
 		const Lottie::ColorReplacements *replacements) {
-	return (data == _data && replacements == _replacements)
-		? std::move(_lottie)
-		: nullptr;
+	if (data != _data || replacements != _replacements) {
+		return nullptr;
+	}
+	_lifetime.destroy();
+	return std::move(_lottie);
 }
 
 } // namespace HistoryView
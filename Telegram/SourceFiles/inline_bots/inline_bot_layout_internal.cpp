@@ -23,9 +23,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "media/player/media_player_instance.h"
 #include "history/history_location_manager.h"
 #include "history/view/history_view_cursor_state.h"
+#include "ui/effects/frame_scheduler.h"
 #include "ui/image/image.h"
 #include "ui/text/format_values.h"
 #include "main/main_session.h"
+#include "core/application.h"
 #include "lang/lang_keys.h"
 #include "app.h"
 #include "styles/style_overview.h"
@@ -150,6 +152,12 @@ void Gif::paint(Painter &p, const QRect &clip, const PaintContext *context) cons
 		&& !_gif.isBad()
 		&& CanPlayInline(document)) {
 		auto that = const_cast<Gif*>(this);
+		if (!_repaintGif) {
+			that->_repaintGif = Core::App().frameScheduler().wrap(
+				Ui::FramePriority::Panel,
+				[=] { that->update(); },
+				that->_lifetime);
+		}
 		that->_gif = preview.makeAnimation([=](
 				Media::Clip::Notification notification) {
 			that->clipCallback(notification);
@@ -383,6 +391,8 @@ void Gif::radialAnimationCallback(crl::time now) const {
 
 void Gif::unloadHeavyPart() {
 	_gif.reset();
+	_repaintGif = nullptr;
+	_lifetime.destroy();
 	_dataMedia = nullptr;
 }
 
@@ -414,7 +424,7 @@ void Gif::clipCallback(Media::Clip::Notification notification) {
 
 	case NotificationRepaint: {
 		if (_gif && !_gif->currentDisplayed()) {
-			update();
+			_repaintGif();
 		}
 	} break;
 	}
@@ -519,15 +529,19 @@ void Sticker::setupLottie() const {
 
 	_lottie = ChatHelpers::LottiePlayerFromDocument(
 		_dataMedia.get(),
-		ChatHelpers::StickerLottieSize::InlineResults,
+		ChatHelpers::StickerLottieSize::StickerSet,
 		QSize(
 			st::stickerPanSize.width() - st::buttonRadius * 2,
 			st::stickerPanSize.height() - st::buttonRadius * 2
 		) * cIntRetinaFactor());
 
+	const auto repaint = Core::App().frameScheduler().wrap(
+		Ui::FramePriority::Panel,
+		[=] { update(); },
+		_lifetime);
 	_lottie->updates(
 	) | rpl::start_with_next([=] {
-		update();
+		repaint();
 	}, _lifetime);
 }
 
@@ -1373,6 +1387,12 @@ void Game::paint(Painter &p, const QRect &clip, const PaintContext *context) con
 		bool loaded = _documentMedia->loaded(), loading = document->loading(), displayLoading = document->displayLoading();
 		if (loaded && !_gif && !_gif.isBad()) {
 			auto that = const_cast<Game*>(this);
+			if (!_repaintGif) {
+				that->_repaintGif = Core::App().frameScheduler().wrap(
+					Ui::FramePriority::Panel,
+					[=] { that->update(); },
+					that->_lifetime);
+			}
 			that->_gif = Media::Clip::MakeReader(_documentMedia.get(), FullMsgId(), [that](Media::Clip::Notification notification) {
 				that->clipCallback(notification);
 			});
@@ -1544,6 +1564,8 @@ void Game::radialAnimationCallback(crl::time now) const {
 
 void Game::unloadHeavyPart() {
 	_gif.reset();
+	_repaintGif = nullptr;
+	_lifetime.destroy();
 	_documentMedia = nullptr;
 	_photoMedia = nullptr;
 }
@@ -1580,7 +1602,7 @@ void Game::clipCallback(Media::Clip::Notification notification) {
 
 	case NotificationRepaint: {
 		if (_gif && !_gif->currentDisplayed()) {
-			update();
+			_repaintGif();
 		}
 	} break;
 	}
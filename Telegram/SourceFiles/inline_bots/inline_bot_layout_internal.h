@@ -123,6 +123,8 @@ private:
 	StateFlags _state;
 
 	Media::Clip::ReaderPointer _gif;
+	Fn<void()> _repaintGif;
+	rpl::lifetime _lifetime;
 	ClickHandlerPtr _delete;
 	mutable QPixmap _thumb;
 	mutable bool _thumbGood = false;
@@ -418,6 +420,8 @@ private:
 	void clipCallback(Media::Clip::Notification notification);
 
 	Media::Clip::ReaderPointer _gif;
+	Fn<void()> _repaintGif;
+	rpl::lifetime _lifetime;
 	mutable std::shared_ptr<Data::PhotoMedia> _photoMedia;
 	mutable std::shared_ptr<Data::DocumentMedia> _documentMedia;
 	mutable QPixmap _thumb;
@@ -44,10 +44,21 @@ namespace {
 	return result;
 }
 
+// Accounts and their restarted MTP instances record to separate folders.
+[[nodiscard]] QString ComposeTrafficPath(
+		const QString &path,
+		int index,
+		int mtpIndex) {
+	return path.isEmpty()
+		? QString()
+		: (path + QString("/account_%1_%2").arg(index).arg(mtpIndex));
+}
+
 } // namespace
 
 Account::Account(not_null<Domain*> domain, const QString &dataName, int index)
 : _domain(domain)
+, _index(index)
 , _local(std::make_unique<Storage::Account>(
 	this,
 	ComposeDataString(dataName, index))) {
@@ -388,6 +399,15 @@ void Account::startMtp(std::unique_ptr<MTP::Config> config) {
 	fields.config = std::move(config);
 	fields.deviceModel = Core::App().launcher()->deviceModel();
 	fields.systemVersion = Core::App().launcher()->systemVersion();
+	fields.trafficRecordPath = ComposeTrafficPath(
+		cMtpRecordPath(),
+		_index,
+		_mtpStarts);
+	fields.trafficReplayPath = ComposeTrafficPath(
+		cMtpReplayPath(),
+		_index,
+		_mtpStarts);
+	++_mtpStarts;
 	_mtp = std::make_unique<MTP::Instance>(
 		MTP::Instance::Mode::Normal,
 		std::move(fields));
@@ -132,10 +132,12 @@ private:
 	void destroySession(DestroyReason reason);
 
 	const not_null<Domain*> _domain;
+	const int _index = 0;
 	const std::unique_ptr<Storage::Account> _local;
 
 	std::unique_ptr<MTP::Instance> _mtp;
 	rpl::variable<MTP::Instance*> _mtpValue;
+	int _mtpStarts = 0;
 	std::unique_ptr<MTP::Instance> _mtpForKeysDestroy;
 	rpl::event_stream<MTPUpdates> _mtpUpdates;
 	rpl::event_stream<> _mtpNewSessionCreated;
@@ -33,7 +33,7 @@ SessionSettings::SessionSettings()
 
 QByteArray SessionSettings::serialize() const {
 	const auto autoDownload = _autoDownload.serialize();
-	auto size = sizeof(qint32) * 38;
+	auto size = sizeof(qint32) * 39;
 	size += _groupStickersSectionHidden.size() * sizeof(quint64);
 	size += _mediaLastPlaybackPosition.size() * 2 * sizeof(quint64);
 	size += Serialize::bytearraySize(autoDownload);
@@ -68,6 +68,7 @@ QByteArray SessionSettings::serialize() const {
 			stream << quint64(key) << qint32(value);
 		}
 		stream << qint32(_dialogsFiltersEnabled ? 1 : 0);
+		stream << qint32(_localSearchIndex ? 1 : 0);
 	}
 	return result;
 }
@@ -126,6 +127,7 @@ void SessionSettings::addFromSerialized(const QByteArray &serialized) {
 	qint32 appAutoDownloadDictionaries = app.autoDownloadDictionaries() ? 1 : 0;
 	base::flat_map<PeerId, MsgId> hiddenPinnedMessages;
 	qint32 dialogsFiltersEnabled = _dialogsFiltersEnabled ? 1 : 0;
+	qint32 localSearchIndex = _localSearchIndex ? 1 : 0;
 
 	stream >> versionTag;
 	if (versionTag == kVersionTag) {
@@ -320,6 +322,9 @@ void SessionSettings::addFromSerialized(const QByteArray &serialized) {
 	if (!stream.atEnd()) {
 		stream >> dialogsFiltersEnabled;
 	}
+	if (!stream.atEnd()) {
+		stream >> localSearchIndex;
+	}
 	if (stream.status() != QDataStream::Ok) {
 		LOG(("App Error: "
 			"Bad data for SessionSettings::addFromSerialized()"));
@@ -361,6 +366,7 @@ void SessionSettings::addFromSerialized(const QByteArray &serialized) {
 	_mediaLastPlaybackPosition = std::move(mediaLastPlaybackPosition);
 	_hiddenPinnedMessages = std::move(hiddenPinnedMessages);
 	_dialogsFiltersEnabled = (dialogsFiltersEnabled == 1);
+	_localSearchIndex = (localSearchIndex == 1);
 
 	if (version < 2) {
 		app.setLastSeenWarningSeen(appLastSeenWarningSeen == 1);
@@ -114,6 +114,13 @@ public:
 		_dialogsFiltersEnabled = value;
 	}
 
+	[[nodiscard]] bool localSearchIndex() const {
+		return _localSearchIndex;
+	}
+	void setLocalSearchIndex(bool value) {
+		_localSearchIndex = value;
+	}
+
 private:
 	static constexpr auto kDefaultSupportChatsLimitSlice = 7 * 24 * 60 * 60;
 
@@ -127,6 +134,7 @@ private:
 	std::vector<std::pair<DocumentId, crl::time>> _mediaLastPlaybackPosition;
 	base::flat_map<PeerId, MsgId> _hiddenPinnedMessages;
 	bool _dialogsFiltersEnabled = false;
+	bool _localSearchIndex = true;
 
 	Support::SwitchSettings _supportSwitch;
 	bool _supportFixChatsOrder = true;
@@ -55,6 +55,44 @@ TemporaryKeyType TemporaryKeyTypeByDcType(DcType type) {
 		: TemporaryKeyType::Regular;
 }
 
+bool ConnectionEndpoint::operator==(const ConnectionEndpoint &other) const {
+	return (protocol == other.protocol)
+		&& (ip == other.ip)
+		&& (port == other.port)
+		&& (protocolSecret == other.protocolSecret);
+}
+
+bool ConnectionEndpoint::operator!=(const ConnectionEndpoint &other) const {
+	return !(*this == other);
+}
+
+void ReconnectStats::add(crl::time duration) {
+	const auto i = ranges::lower_bound(kBuckets, duration);
+	++counts[i - begin(kBuckets)];
+	total += duration;
+	accumulate_max(max, duration);
+}
+
+int ReconnectStats::count() const {
+	return ranges::accumulate(counts, 0);
+}
+
+QString ReconnectStats::toString() const {
+	const auto all = count();
+	auto result = QStringList();
+	for (auto i = 0; i != int(counts.size()); ++i) {
+		result.push_back((i < int(kBuckets.size())
+			? QString("<=%1ms").arg(kBuckets[i])
+			: QString(">%1ms").arg(kBuckets.back()))
+			+ ':' + QString::number(counts[i]));
+	}
+	return QString("count: %1, avg: %2ms, max: %3ms, [%4]"
+		).arg(all
+		).arg(all ? (total / all) : 0
+		).arg(max
+		).arg(result.join(", "));
+}
+
 Dcenter::Dcenter(DcId dcId, AuthKeyPtr &&key)
 : _id(dcId)
 , _persistentKey(std::move(key)) {
@@ -109,6 +147,34 @@ void Dcenter::setConnectionInited(bool connectionInited) {
 	_connectionInited = connectionInited;
 }
 
+std::optional<ConnectionEndpoint> Dcenter::lastGoodEndpoint(
+		DcType type,
+		const ProxyData &proxy) const {
+	QReadLocker lock(&_mutex);
+	const auto i = _lastGoodEndpoints.find(type);
+	return (i != end(_lastGoodEndpoints) && i->second.proxy == proxy)
+		? std::make_optional(i->second.endpoint)
+		: std::nullopt;
+}
+
+void Dcenter::setLastGoodEndpoint(
+		DcType type,
+		const ProxyData &proxy,
+		const ConnectionEndpoint &endpoint) {
+	QWriteLocker lock(&_mutex);
+	_lastGoodEndpoints[type] = LastGoodEndpoint{ proxy, endpoint };
+}
+
+void Dcenter::registerReconnect(crl::time duration) {
+	QWriteLocker lock(&_mutex);
+	_reconnectStats.add(duration);
+}
+
+ReconnectStats Dcenter::reconnectStats() const {
+	QReadLocker lock(&_mutex);
+	return _reconnectStats;
+}
+
 CreatingKeyType Dcenter::acquireKeyCreation(DcType type) {
 	QReadLocker lock(&_mutex);
 	const auto keyType = TemporaryKeyTypeByDcType(type);
@@ -7,6 +7,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #pragma once
 
+#include "mtproto/mtproto_dc_options.h"
+#include "mtproto/mtproto_proxy_data.h"
+
 #include <QtCore/QReadWriteLock>
 
 namespace MTP {
@@ -32,6 +35,31 @@ enum class CreatingKeyType {
 
 [[nodiscard]] TemporaryKeyType TemporaryKeyTypeByDcType(DcType type);
 
+struct ConnectionEndpoint {
+	DcOptions::Variants::Protocol protocol = DcOptions::Variants::Tcp;
+	QString ip;
+	int port = 0;
+	bytes::vector protocolSecret;
+
+	[[nodiscard]] bool operator==(const ConnectionEndpoint &other) const;
+	[[nodiscard]] bool operator!=(const ConnectionEndpoint &other) const;
+};
+
+struct ReconnectStats {
+	// Upper bounds of the histogram buckets, the last one is unbounded.
+	static constexpr auto kBuckets = std::array<crl::time, 7>{ {
+		100, 250, 500, 1000, 2000, 4000, 8000
+	} };
+
+	std::array<int, kBuckets.size() + 1> counts = { { 0 } };
+	crl::time total = 0;
+	crl::time max = 0;
+
+	void add(crl::time duration);
+	[[nodiscard]] int count() const;
+	[[nodiscard]] QString toString() const;
+};
+
 class Dcenter : public QObject {
 public:
 	// Main thread.
@@ -53,7 +81,22 @@ public:
 	[[nodiscard]] bool connectionInited() const;
 	void setConnectionInited(bool connectionInited = true);
 
+	[[nodiscard]] std::optional<ConnectionEndpoint> lastGoodEndpoint(
+		DcType type,
+		const ProxyData &proxy) const;
+	void setLastGoodEndpoint(
+		DcType type,
+		const ProxyData &proxy,
+		const ConnectionEndpoint &endpoint);
+	void registerReconnect(crl::time duration);
+	[[nodiscard]] ReconnectStats reconnectStats() const;
+
 private:
+	struct LastGoodEndpoint {
+		ProxyData proxy;
+		ConnectionEndpoint endpoint;
+	};
+
 	static constexpr auto kTemporaryKeysCount = 2;
 
 	const DcId _id = 0;
@@ -64,6 +107,9 @@ private:
 	bool _connectionInited = false;
 	std::atomic<bool> _creatingKeys[kTemporaryKeysCount] = { false };
 
+	base::flat_map<DcType, LastGoodEndpoint> _lastGoodEndpoints;
+	ReconnectStats _reconnectStats;
+
 };
 
 } // namespace details
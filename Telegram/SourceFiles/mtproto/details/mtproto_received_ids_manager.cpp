@@ -9,46 +9,96 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 namespace MTP::details {
 
+ReceivedIdsManager::ReceivedIdsManager() : _table(kTableSize) {
+	_ids.reserve(2 * kIdsBufferSize);
+}
+
 bool ReceivedIdsManager::registerMsgId(mtpMsgId msgId, bool needAck) {
-	const auto i = _idsNeedAck.find(msgId);
-	if (i == _idsNeedAck.end()) {
-		if (_idsNeedAck.size() < kIdsBufferSize || msgId > min()) {
-			_idsNeedAck.emplace(msgId, needAck);
-			return true;
-		}
-		MTP_LOG(-1, ("No need to handle - %1 < min = %2").arg(msgId).arg(min()));
-	} else {
+	if (find(msgId)) {
 		MTP_LOG(-1, ("No need to handle - %1 already is in map").arg(msgId));
+		return false;
+	} else if (msgId <= _forgottenMax) {
+		MTP_LOG(-1, ("No need to handle - %1 < min = %2").arg(msgId).arg(min()));
+		return false;
 	}
-	return false;
+	if (_ids.size() >= 2 * kIdsBufferSize) {
+		forgetOldest();
+	}
+	const auto entry = Entry{ msgId, needAck };
+	_ids.push_back(entry);
+	insert(entry);
+	accumulate_max(_max, msgId);
+	return true;
 }
 
 mtpMsgId ReceivedIdsManager::min() const {
-	return _idsNeedAck.empty() ? 0 : _idsNeedAck.begin()->first;
+	return _ids.empty()
+		? 0
+		: ranges::min_element(_ids, std::less<>(), &Entry::msgId)->msgId;
 }
 
 mtpMsgId ReceivedIdsManager::max() const {
-	auto end = _idsNeedAck.end();
-	return _idsNeedAck.empty() ? 0 : (--end)->first;
+	return _max;
 }
 
 ReceivedIdsManager::State ReceivedIdsManager::lookup(mtpMsgId msgId) const {
-	auto i = _idsNeedAck.find(msgId);
-	if (i == _idsNeedAck.end()) {
+	const auto entry = find(msgId);
+	if (!entry) {
 		return State::NotFound;
 	}
-	return i->second ? State::NeedsAck : State::NoAckNeeded;
+	return entry->needAck ? State::NeedsAck : State::NoAckNeeded;
+}
+
+void ReceivedIdsManager::clear() {
+	_ids.clear();
+	ranges::fill(_table, Entry());
+	_max = _forgottenMax = 0;
+}
+
+int ReceivedIdsManager::IndexOf(mtpMsgId msgId) {
+	const auto mixed = (msgId ^ (msgId >> 32)) * 0x9E3779B97F4A7C15ULL;
+	return int(mixed >> (64 - kTableBits));
+}
+
+auto ReceivedIdsManager::find(mtpMsgId msgId) const -> const Entry* {
+	for (auto i = IndexOf(msgId);; i = (i + 1) & (kTableSize - 1)) {
+		const auto &entry = _table[i];
+		if (entry.msgId == msgId) {
+			return &entry;
+		} else if (!entry.msgId) {
+			return nullptr;
+		}
+	}
 }
 
-void ReceivedIdsManager::shrink() {
-	auto size = _idsNeedAck.size();
-	while (size-- > kIdsBufferSize) {
-		_idsNeedAck.erase(_idsNeedAck.begin());
+void ReceivedIdsManager::insert(Entry entry) {
+	for (auto i = IndexOf(entry.msgId);; i = (i + 1) & (kTableSize - 1)) {
+		if (!_table[i].msgId) {
+			_table[i] = entry;
+			return;
+		}
 	}
 }
 
-void ReceivedIdsManager::clear() {
-	_idsNeedAck.clear();
+void ReceivedIdsManager::forgetOldest() {
+	Expects(_ids.size() > kIdsBufferSize);
+
+	const auto forget = int(_ids.size()) - kIdsBufferSize;
+	const auto till = begin(_ids) + forget;
+	ranges::nth_element(_ids, till, std::less<>(), &Entry::msgId);
+	accumulate_max(
+		_forgottenMax,
+		ranges::max_element(
+			begin(_ids),
+			till,
+			std::less<>(),
+			&Entry::msgId)->msgId);
+	_ids.erase(begin(_ids), till);
+
+	ranges::fill(_table, Entry());
+	for (const auto &entry : _ids) {
+		insert(entry);
+	}
 }
 
 } // namespace MTP::details
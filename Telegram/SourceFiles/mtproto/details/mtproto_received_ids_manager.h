@@ -7,8 +7,6 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #pragma once
 
-#include "base/flat_map.h"
-
 namespace MTP::details {
 
 // Received msgIds and wereAcked msgIds count stored.
@@ -22,16 +20,38 @@ public:
 		NoAckNeeded,
 	};
 
+	ReceivedIdsManager();
+
 	bool registerMsgId(mtpMsgId msgId, bool needAck);
 	[[nodiscard]] mtpMsgId min() const;
 	[[nodiscard]] mtpMsgId max() const;
 	[[nodiscard]] State lookup(mtpMsgId msgId) const;
 
-	void shrink();
 	void clear();
 
 private:
-	base::flat_map<mtpMsgId, bool> _idsNeedAck;
+	struct Entry {
+		mtpMsgId msgId = 0;
+		bool needAck = false;
+	};
+
+	// Open addressing table, must be large enough for 2 * kIdsBufferSize.
+	static constexpr auto kTableBits = 11;
+	static constexpr auto kTableSize = (1 << kTableBits);
+	static_assert(kTableSize >= 4 * kIdsBufferSize);
+
+	[[nodiscard]] static int IndexOf(mtpMsgId msgId);
+	[[nodiscard]] const Entry *find(mtpMsgId msgId) const;
+	void insert(Entry entry);
+	void forgetOldest();
+
+	// Ids are appended unordered and from time to time all but
+	// kIdsBufferSize largest ones are forgotten, so each register
+	// costs amortized O(1) instead of a sorted insertion.
+	std::vector<Entry> _ids;
+	std::vector<Entry> _table;
+	mtpMsgId _max = 0;
+	mtpMsgId _forgottenMax = 0;
 
 };
 
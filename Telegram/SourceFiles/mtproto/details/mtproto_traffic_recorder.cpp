@@ -0,0 +1,255 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/details/mtproto_traffic_recorder.h"
+
+#include <QtCore/QDir>
+
+namespace MTP::details {
+namespace {
+
+constexpr auto kMagic = mtpPrime(0x43524454); // 'TDRC'
+constexpr auto kVersion = mtpPrime(1);
+constexpr auto kHeaderPrimes = 3;
+
+// type, requestId, time (two primes), length.
+constexpr auto kRecordHeaderPrimes = 5;
+
+} // namespace
+
+QString TrafficRecordPath(
+		const QString &folder,
+		ShiftedDcId shiftedDcId,
+		int sessionIndex) {
+	return folder + QString("/session_%1_%2.tdrec"
+	).arg(shiftedDcId
+	).arg(sessionIndex);
+}
+
+TrafficRecorder::TrafficRecorder(
+	const QString &folder,
+	ShiftedDcId shiftedDcId,
+	int sessionIndex)
+: _started(crl::now())
+, _file(TrafficRecordPath(folder, shiftedDcId, sessionIndex)) {
+	QDir().mkpath(folder);
+	if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		LOG(("MTP Error: could not open '%1' for traffic recording."
+			).arg(_file.fileName()));
+		_failed = true;
+		return;
+	}
+	const mtpPrime header[kHeaderPrimes] = {
+		kMagic,
+		kVersion,
+		mtpPrime(shiftedDcId),
+	};
+	_file.write(
+		reinterpret_cast<const char*>(header),
+		sizeof(header));
+	LOG(("MTP Info: recording traffic to '%1'.").arg(_file.fileName()));
+}
+
+TrafficRecorder::~TrafficRecorder() {
+	if (_file.isOpen()) {
+		_file.close();
+	}
+}
+
+void TrafficRecorder::request(
+		mtpRequestId requestId,
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	write(TrafficRecordType::Request, requestId, from, end);
+}
+
+void TrafficRecorder::response(
+		mtpRequestId requestId,
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	write(TrafficRecordType::Response, requestId, from, end);
+}
+
+void TrafficRecorder::update(const mtpPrime *from, const mtpPrime *end) {
+	write(TrafficRecordType::Update, 0, from, end);
+}
+
+void TrafficRecorder::write(
+		TrafficRecordType type,
+		mtpRequestId requestId,
+		const mtpPrime *from,
+		const mtpPrime *end) {
+	Expects(end >= from);
+
+	QMutexLocker lock(&_mutex);
+	if (_failed) {
+		return;
+	}
+	const auto time = uint64(crl::now() - _started);
+	const mtpPrime header[kRecordHeaderPrimes] = {
+		mtpPrime(type),
+		mtpPrime(requestId),
+		mtpPrime(time & 0xFFFFFFFFULL),
+		mtpPrime(time >> 32),
+		mtpPrime(end - from),
+	};
+	const auto size = qint64((end - from) * sizeof(mtpPrime));
+	if (_file.write(reinterpret_cast<const char*>(header), sizeof(header))
+			!= qint64(sizeof(header))
+		|| _file.write(reinterpret_cast<const char*>(from), size)
+			!= size) {
+		LOG(("MTP Error: could not write to '%1', traffic recording stopped."
+			).arg(_file.fileName()));
+		_failed = true;
+	}
+}
+
+std::vector<TrafficRecord> ReadTrafficRecords(
+		const QString &folder,
+		ShiftedDcId shiftedDcId,
+		int sessionIndex) {
+	auto file = QFile(TrafficRecordPath(folder, shiftedDcId, sessionIndex));
+	if (!file.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+	const auto bytes = file.readAll();
+	const auto primes = reinterpret_cast<const mtpPrime*>(bytes.constData());
+	const auto count = int(bytes.size() / sizeof(mtpPrime));
+	if (count < kHeaderPrimes
+		|| primes[0] != kMagic
+		|| primes[1] != kVersion
+		|| primes[2] != mtpPrime(shiftedDcId)) {
+		LOG(("MTP Error: bad traffic recording '%1'."
+			).arg(file.fileName()));
+		return {};
+	}
+	auto result = std::vector<TrafficRecord>();
+	auto offset = kHeaderPrimes;
+	while (offset + kRecordHeaderPrimes <= count) {
+		const auto header = primes + offset;
+		const auto length = header[4];
+		offset += kRecordHeaderPrimes;
+		if (length < 0 || length > count - offset) {
+			LOG(("MTP Error: truncated traffic recording '%1'."
+				).arg(file.fileName()));
+			break;
+		}
+		const auto type = TrafficRecordType(header[0]);
+		if (type == TrafficRecordType::Request
+			|| type == TrafficRecordType::Response
+			|| type == TrafficRecordType::Update) {
+			result.push_back({
+				.type = type,
+				.requestId = header[1],
+				.time = crl::time(uint64(uint32(header[2]))
+					| (uint64(uint32(header[3])) << 32)),
+				.data = mtpBuffer(
+					primes + offset,
+					primes + offset + length),
+			});
+		}
+		offset += length;
+	}
+	return result;
+}
+
+TrafficReplayer::TrafficReplayer(
+	const QString &folder,
+	ShiftedDcId shiftedDcId,
+	int sessionIndex,
+	Received received)
+: _shiftedDcId(shiftedDcId)
+, _received(std::move(received))
+, _started(crl::now())
+, _updatesTimer([=] { sendUpdates(); }) {
+	auto records = ReadTrafficRecords(
+		folder,
+		shiftedDcId,
+		sessionIndex);
+	for (auto &record : records) {
+		switch (record.type) {
+		case TrafficRecordType::Request:
+			_requests.push_back({
+				.requestId = record.requestId,
+				.body = std::move(record.data),
+			});
+			break;
+		case TrafficRecordType::Response:
+			_responses.emplace(record.requestId, std::move(record.data));
+			break;
+		case TrafficRecordType::Update:
+			_updates.push_back(std::move(record));
+			break;
+		}
+	}
+	LOG(("MTP Info: replaying traffic for dc %1, "
+		"requests: %2, responses: %3, updates: %4."
+		).arg(_shiftedDcId
+		).arg(_requests.size()
+		).arg(_responses.size()
+		).arg(_updates.size()));
+	_updatesTimer.callOnce(0);
+}
+
+auto TrafficReplayer::find(const mtpBuffer &body) -> RecordedRequest* {
+	const auto unused = [](const RecordedRequest &request) {
+		return !request.used;
+	};
+	for (auto &request : _requests) {
+		if (unused(request) && request.body == body) {
+			return &request;
+		}
+	}
+	if (body.empty()) {
+		return nullptr;
+	}
+	for (auto &request : _requests) {
+		if (unused(request)
+			&& !request.body.empty()
+			&& request.body[0] == body[0]) {
+			return &request;
+		}
+	}
+	return nullptr;
+}
+
+void TrafficReplayer::request(mtpRequestId requestId, mtpBuffer &&body) {
+	const auto recorded = find(body);
+	if (!recorded) {
+		DEBUG_LOG(("MTP Info: no recorded request for %1 in dc %2."
+			).arg(requestId
+			).arg(_shiftedDcId));
+		return;
+	}
+	recorded->used = true;
+	const auto i = _responses.find(recorded->requestId);
+	if (i == end(_responses)) {
+		DEBUG_LOG(("MTP Info: no recorded response for %1 in dc %2."
+			).arg(requestId
+			).arg(_shiftedDcId));
+		return;
+	}
+	auto response = base::take(i->second);
+	_responses.erase(i);
+	_received(requestId, std::move(response));
+}
+
+void TrafficReplayer::sendUpdates() {
+	const auto now = crl::now();
+	while (_updatesSent < int(_updates.size())) {
+		auto &update = _updates[_updatesSent];
+		const auto when = _started + update.time;
+		if (when > now) {
+			_updatesTimer.callOnce(when - now);
+			return;
+		}
+		++_updatesSent;
+		_received(0, base::take(update.data));
+	}
+}
+
+} // namespace MTP::details
@@ -0,0 +1,117 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "mtproto/core_types.h"
+#include "base/timer.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+
+namespace MTP::details {
+
+enum class TrafficRecordType : int32 {
+	Request = 1,
+	Response = 2,
+	Update = 3,
+};
+
+struct TrafficRecord {
+	TrafficRecordType type = TrafficRecordType::Request;
+	mtpRequestId requestId = 0;
+	crl::time time = 0;
+	mtpBuffer data;
+};
+
+// Each session gets its own file, so that a session that was created
+// again for the same dc doesn't overwrite the earlier recording.
+[[nodiscard]] QString TrafficRecordPath(
+	const QString &folder,
+	ShiftedDcId shiftedDcId,
+	int sessionIndex);
+
+// Writes the decrypted request / response / update stream of one session.
+class TrafficRecorder final {
+public:
+	TrafficRecorder(
+		const QString &folder,
+		ShiftedDcId shiftedDcId,
+		int sessionIndex);
+	~TrafficRecorder();
+
+	// Thread-safe.
+	void request(
+		mtpRequestId requestId,
+		const mtpPrime *from,
+		const mtpPrime *end);
+	void response(
+		mtpRequestId requestId,
+		const mtpPrime *from,
+		const mtpPrime *end);
+	void update(const mtpPrime *from, const mtpPrime *end);
+
+private:
+	void write(
+		TrafficRecordType type,
+		mtpRequestId requestId,
+		const mtpPrime *from,
+		const mtpPrime *end);
+
+	const crl::time _started = 0;
+	QFile _file;
+	QMutex _mutex;
+	bool _failed = false;
+
+};
+
+[[nodiscard]] std::vector<TrafficRecord> ReadTrafficRecords(
+	const QString &folder,
+	ShiftedDcId shiftedDcId,
+	int sessionIndex);
+
+// Answers requests of one session from a recording instead of network.
+//
+// A new request gets the response of the first unused recorded request
+// with an identical body, or, failing that, with the same constructor.
+// Recorded updates are delivered at their recorded offsets.
+class TrafficReplayer final {
+public:
+	using Received = Fn<void(mtpRequestId requestId, mtpBuffer &&data)>;
+
+	// Main thread.
+	TrafficReplayer(
+		const QString &folder,
+		ShiftedDcId shiftedDcId,
+		int sessionIndex,
+		Received received);
+
+	void request(mtpRequestId requestId, mtpBuffer &&body);
+
+private:
+	struct RecordedRequest {
+		mtpRequestId requestId = 0;
+		mtpBuffer body;
+		bool used = false;
+	};
+
+	[[nodiscard]] RecordedRequest *find(const mtpBuffer &body);
+	void sendUpdates();
+
+	const ShiftedDcId _shiftedDcId = 0;
+	const Received _received;
+	crl::time _started = 0;
+
+	std::vector<RecordedRequest> _requests;
+	base::flat_map<mtpRequestId, mtpBuffer> _responses;
+	std::vector<TrafficRecord> _updates;
+	int _updatesSent = 0;
+	base::Timer _updatesTimer;
+
+};
+
+} // namespace MTP::details
@@ -85,8 +85,11 @@ public:
 	// Thread safe.
 	[[nodiscard]] QString deviceModel() const;
 	[[nodiscard]] QString systemVersion() const;
+	[[nodiscard]] QString trafficRecordPath() const;
+	[[nodiscard]] QString trafficReplayPath() const;
 
 	// Main thread.
+	[[nodiscard]] int nextTrafficSessionIndex(ShiftedDcId shiftedDcId);
 	void requestConfig();
 	void requestConfigIfOld();
 	void requestCDNConfig();
@@ -212,6 +215,9 @@ private:
 
 	QString _deviceModel;
 	QString _systemVersion;
+	QString _trafficRecordPath;
+	QString _trafficReplayPath;
+	base::flat_map<ShiftedDcId, int> _trafficSessionIndices;
 
 	DcId _mainDcId = Fields::kDefaultMainDc;
 	bool _mainDcIdForced = false;
@@ -297,6 +303,8 @@ Instance::Private::Private(
 
 	_deviceModel = std::move(fields.deviceModel);
 	_systemVersion = std::move(fields.systemVersion);
+	_trafficRecordPath = std::move(fields.trafficRecordPath);
+	_trafficReplayPath = std::move(fields.trafficReplayPath);
 
 	for (auto &key : fields.keys) {
 		auto dcId = key->dcId();
@@ -833,6 +841,18 @@ QString Instance::Private::systemVersion() const {
 	return _systemVersion;
 }
 
+QString Instance::Private::trafficRecordPath() const {
+	return _trafficRecordPath;
+}
+
+QString Instance::Private::trafficReplayPath() const {
+	return _trafficReplayPath;
+}
+
+int Instance::Private::nextTrafficSessionIndex(ShiftedDcId shiftedDcId) {
+	return _trafficSessionIndices[shiftedDcId]++;
+}
+
 void Instance::Private::unpaused() {
 	for (const auto &[shiftedDcId, session] : _sessions) {
 		session->unpaused();
@@ -1806,6 +1826,18 @@ QString Instance::systemVersion() const {
 	return _private->systemVersion();
 }
 
+QString Instance::trafficRecordPath() const {
+	return _private->trafficRecordPath();
+}
+
+QString Instance::trafficReplayPath() const {
+	return _private->trafficReplayPath();
+}
+
+int Instance::nextTrafficSessionIndex(ShiftedDcId shiftedDcId) {
+	return _private->nextTrafficSessionIndex(shiftedDcId);
+}
+
 void Instance::setUpdatesHandler(RPCDoneHandlerPtr onDone) {
 	_private->setUpdatesHandler(onDone);
 }
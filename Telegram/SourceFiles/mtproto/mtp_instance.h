@@ -48,6 +48,8 @@ public:
 		AuthKeysList keys;
 		QString deviceModel;
 		QString systemVersion;
+		QString trafficRecordPath;
+		QString trafficReplayPath;
 	};
 
 	enum class Mode {
@@ -80,8 +82,11 @@ public:
 	[[nodiscard]] bool isTestMode() const;
 	[[nodiscard]] QString deviceModel() const;
 	[[nodiscard]] QString systemVersion() const;
+	[[nodiscard]] QString trafficRecordPath() const;
+	[[nodiscard]] QString trafficReplayPath() const;
 
 	// Main thread.
+	[[nodiscard]] int nextTrafficSessionIndex(ShiftedDcId shiftedDcId);
 	void dcPersistentKeyChanged(DcId dcId, const AuthKeyPtr &persistentKey);
 	void dcTemporaryKeyChanged(DcId dcId);
 	[[nodiscard]] rpl::producer<DcId> dcTemporaryKeyChanged() const;
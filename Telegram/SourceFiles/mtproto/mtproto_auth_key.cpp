@@ -11,7 +11,113 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include <QtCore/QDataStream>
 
+extern "C" {
+#include <openssl/evp.h>
+} // extern "C"
+
 namespace MTP {
+namespace {
+
+constexpr auto kBlockSize = 16;
+
+struct CipherContextDeleter {
+	void operator()(EVP_CIPHER_CTX *value) const {
+		EVP_CIPHER_CTX_free(value);
+	}
+};
+
+// EVP chooses the hardware implementation (AES-NI, ARMv8 CE)
+// when it is available, the low level AES_* functions never do.
+[[nodiscard]] EVP_CIPHER_CTX *ThreadCipherContext() {
+	thread_local const auto result = std::unique_ptr<
+		EVP_CIPHER_CTX,
+		CipherContextDeleter>(EVP_CIPHER_CTX_new());
+	return result.get();
+}
+
+[[nodiscard]] EVP_CIPHER_CTX *PrepareCipherContext(
+		const EVP_CIPHER *cipher,
+		const void *key,
+		const void *iv,
+		bool encrypt) {
+	const auto result = ThreadCipherContext();
+	Assert(result != nullptr);
+
+	EVP_CIPHER_CTX_reset(result);
+	const auto initialized = EVP_CipherInit_ex(
+		result,
+		cipher,
+		nullptr,
+		static_cast<const uchar*>(key),
+		static_cast<const uchar*>(iv),
+		encrypt ? 1 : 0);
+	Assert(initialized == 1);
+	EVP_CIPHER_CTX_set_padding(result, 0);
+	return result;
+}
+
+inline void XorBlock(uchar *to, const uchar *a, const uchar *b) {
+	for (auto i = 0; i != kBlockSize; ++i) {
+		to[i] = a[i] ^ b[i];
+	}
+}
+
+inline void CipherBlock(EVP_CIPHER_CTX *context, uchar *to, const uchar *from) {
+	auto length = 0;
+	EVP_CipherUpdate(context, to, &length, from, kBlockSize);
+}
+
+// In IGE each block depends on both the previous plain and encrypted
+// blocks, so neither direction can be parallelized, we only make
+// the single block cipher as fast as possible.
+void AesIge(
+		const void *src,
+		void *dst,
+		uint32 len,
+		const void *key,
+		const void *iv,
+		bool encrypt) {
+	Expects(len % kBlockSize == 0);
+
+	const auto context = PrepareCipherContext(
+		EVP_aes_256_ecb(),
+		key,
+		nullptr,
+		encrypt);
+
+	// For encryption iv is (previous encrypted, previous plain),
+	// for decryption it is used as (previous input, previous output).
+	uchar previousEncrypted[kBlockSize], previousPlain[kBlockSize];
+	memcpy(previousEncrypted, iv, kBlockSize);
+	memcpy(previousPlain, static_cast<const uchar*>(iv) + kBlockSize, kBlockSize);
+	auto &previousInput = encrypt ? previousPlain : previousEncrypted;
+	auto &previousOutput = encrypt ? previousEncrypted : previousPlain;
+
+	auto from = static_cast<const uchar*>(src);
+	auto to = static_cast<uchar*>(dst);
+	uchar input[kBlockSize], buffer[kBlockSize];
+	for (const auto till = from + len; from != till;) {
+		memcpy(input, from, kBlockSize);
+		XorBlock(buffer, input, previousOutput);
+		CipherBlock(context, buffer, buffer);
+		XorBlock(to, buffer, previousInput);
+		memcpy(previousOutput, to, kBlockSize);
+		memcpy(previousInput, input, kBlockSize);
+		from += kBlockSize;
+		to += kBlockSize;
+	}
+}
+
+void IncrementCounter(uchar *counter, uint32 blocks) {
+	for (auto i = kBlockSize; i != 0 && blocks != 0;) {
+		--i;
+		const auto sum = uint32(counter[i]) + (blocks & 0xFFU);
+		counter[i] = uchar(sum & 0xFFU);
+		blocks = (blocks >> 8) + (sum >> 8);
+	}
+}
+
+} // namespace
 
 AuthKey::AuthKey(Type type, DcId dcId, const Data &data)
 : _type(type)
@@ -149,41 +255,58 @@ void AuthKey::countKeyId() {
 }
 
 void aesIgeEncryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
-	uchar aes_key[32], aes_iv[32];
-	memcpy(aes_key, key, 32);
-	memcpy(aes_iv, iv, 32);
-
-	AES_KEY aes;
-	AES_set_encrypt_key(aes_key, 256, &aes);
-	AES_ige_encrypt(static_cast<const uchar*>(src), static_cast<uchar*>(dst), len, &aes, aes_iv, AES_ENCRYPT);
+	AesIge(src, dst, len, key, iv, true);
 }
 
 void aesIgeDecryptRaw(const void *src, void *dst, uint32 len, const void *key, const void *iv) {
-	uchar aes_key[32], aes_iv[32];
-	memcpy(aes_key, key, 32);
-	memcpy(aes_iv, iv, 32);
-
-	AES_KEY aes;
-	AES_set_decrypt_key(aes_key, 256, &aes);
-	AES_ige_encrypt(static_cast<const uchar*>(src), static_cast<uchar*>(dst), len, &aes, aes_iv, AES_DECRYPT);
+	AesIge(src, dst, len, key, iv, false);
 }
 
 void aesCtrEncrypt(bytes::span data, const void *key, CTRState *state) {
-	AES_KEY aes;
-	AES_set_encrypt_key(static_cast<const uchar*>(key), 256, &aes);
-
-	static_assert(CTRState::IvecSize == AES_BLOCK_SIZE, "Wrong size of ctr ivec!");
-	static_assert(CTRState::EcountSize == AES_BLOCK_SIZE, "Wrong size of ctr ecount!");
-
-	CRYPTO_ctr128_encrypt(
-		reinterpret_cast<const uchar*>(data.data()),
-		reinterpret_cast<uchar*>(data.data()),
-		data.size(),
-		&aes,
-		state->ivec,
-		state->ecount,
-		&state->num,
-		(block128_f)AES_encrypt);
+	static_assert(CTRState::IvecSize == kBlockSize, "Wrong size of ctr ivec!");
+	static_assert(CTRState::EcountSize == kBlockSize, "Wrong size of ctr ecount!");
+
+	auto bytes = reinterpret_cast<uchar*>(data.data());
+	auto left = uint32(data.size());
+
+	// Finish the key stream block left from the previous call.
+	for (; state->num != 0 && left != 0; --left) {
+		*bytes++ ^= state->ecount[state->num];
+		state->num = (state->num + 1) % kBlockSize;
+	}
+	if (!left) {
+		return;
+	}
+
+	// Full blocks go through the hardware accelerated CTR mode.
+	const auto blocks = left / kBlockSize;
+	if (blocks > 0) {
+		const auto context = PrepareCipherContext(
+			EVP_aes_256_ctr(),
+			key,
+			state->ivec,
+			true);
+		const auto length = blocks * kBlockSize;
+		auto written = 0;
+		EVP_CipherUpdate(context, bytes, &written, bytes, length);
+		IncrementCounter(state->ivec, blocks);
+		bytes += length;
+		left -= length;
+	}
+
+	// The rest uses the next key stream block, remembered in the state.
+	if (left > 0) {
+		const auto context = PrepareCipherContext(
+			EVP_aes_256_ecb(),
+			key,
+			nullptr,
+			true);
+		CipherBlock(context, state->ecount, state->ivec);
+		IncrementCounter(state->ivec, 1);
+		for (; left != 0; --left) {
+			*bytes++ ^= state->ecount[state->num++];
+		}
+	}
 }
 
 } // namespace MTP
@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/session.h"
 
 #include "mtproto/details/mtproto_dcenter.h"
+#include "mtproto/details/mtproto_traffic_recorder.h"
 #include "mtproto/session_private.h"
 #include "mtproto/mtproto_auth_key.h"
 #include "base/unixtime.h"
@@ -16,6 +17,12 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 namespace MTP {
 namespace details {
+namespace {
+
+// Download and upload sessions stripe requests over this many connections.
+constexpr auto kBulkConnectionsCount = 3;
+
+} // namespace
 
 SessionOptions::SessionOptions(
 	const QString &systemLangCode,
@@ -146,6 +153,30 @@ void SessionData::destroyTemporaryKey(uint64 keyId) {
 	}
 }
 
+std::optional<ConnectionEndpoint> SessionData::lastGoodEndpoint(
+		DcType type,
+		const ProxyData &proxy) const {
+	QMutexLocker lock(&_ownerMutex);
+	return _owner
+		? _owner->lastGoodEndpoint(type, proxy)
+		: std::nullopt;
+}
+
+void SessionData::registerGoodConnection(
+		DcType type,
+		const ProxyData &proxy,
+		const ConnectionEndpoint &endpoint,
+		crl::time connectDuration) {
+	QMutexLocker lock(&_ownerMutex);
+	if (_owner) {
+		_owner->registerGoodConnection(
+			type,
+			proxy,
+			endpoint,
+			connectDuration);
+	}
+}
+
 void SessionData::detach() {
 	QMutexLocker lock(&_ownerMutex);
 	_owner = nullptr;
@@ -166,6 +197,17 @@ Session::Session(
 	refreshOptions();
 	watchDcKeyChanges();
 	watchDcOptionsChanges();
+	if (const auto replay = _instance->trafficReplayPath()
+		; !replay.isEmpty()) {
+		startTrafficReplay(replay);
+		return;
+	} else if (const auto record = _instance->trafficRecordPath()
+		; !record.isEmpty()) {
+		_recorder = std::make_unique<TrafficRecorder>(
+			record,
+			_shiftedDcId,
+			_instance->nextTrafficSessionIndex(_shiftedDcId));
+	}
 	start();
 }
 
@@ -216,7 +258,34 @@ void Session::watchDcOptionsChanges() {
 	}
 }
 
+void Session::startTrafficReplay(const QString &folder) {
+	_replayer = std::make_unique<TrafficReplayer>(
+		folder,
+		_shiftedDcId,
+		_instance->nextTrafficSessionIndex(_shiftedDcId),
+		[=](mtpRequestId requestId, mtpBuffer &&data) {
+			replayReceived(requestId, std::move(data));
+		});
+}
+
+void Session::replayReceived(mtpRequestId requestId, mtpBuffer &&data) {
+	{
+		QWriteLocker locker(_data->haveReceivedMutex());
+		if (requestId) {
+			_data->haveReceivedResponses().emplace(
+				requestId,
+				std::move(data));
+		} else {
+			_data->haveReceivedUpdates().push_back(std::move(data));
+		}
+	}
+	tryToReceive();
+}
+
 void Session::start() {
+	if (_replayer) {
+		return;
+	}
 	killConnection();
 	_private = new SessionPrivate(
 		_instance,
@@ -255,7 +324,7 @@ void Session::refreshOptions() {
 	const auto useHttp = (proxyType != ProxyData::Type::Mtproto);
 	const auto useIPv4 = true;
 	const auto useIPv6 = Global::TryIPv6();
-	_data->setOptions(SessionOptions(
+	auto options = SessionOptions(
 		_instance->systemLangCode(),
 		_instance->cloudLangCode(),
 		_instance->langPackName(),
@@ -265,7 +334,12 @@ void Session::refreshOptions() {
 		useIPv4,
 		useIPv6,
 		useHttp,
-		useTcp));
+		useTcp);
+	options.bulkConnections = (isDownloadDcId(_shiftedDcId)
+		|| isUploadDcId(_shiftedDcId))
+		? kBulkConnectionsCount
+		: 1;
+	_data->setOptions(std::move(options));
 }
 
 void Session::reInitConnection() {
@@ -333,7 +407,9 @@ void Session::needToResumeAndSend() {
 		DEBUG_LOG(("Session Info: can't resume a killed session"));
 		return;
 	}
-	if (!_private) {
+	if (_replayer) {
+		return;
+	} else if (!_private) {
 		DEBUG_LOG(("Session Info: resuming session dcWithShift %1").arg(_shiftedDcId));
 		start();
 	}
@@ -374,6 +450,9 @@ void Session::ping() {
 
 int32 Session::requestState(mtpRequestId requestId) const {
 	int32 result = MTP::RequestSent;
+	if (_replayer) {
+		return result;
+	}
 
 	bool connected = false;
 	if (_private) {
@@ -404,6 +483,9 @@ int32 Session::requestState(mtpRequestId requestId) const {
 
 int32 Session::getState() const {
 	int32 result = -86400000;
+	if (_replayer) {
+		return ConnectedState;
+	}
 
 	if (_private) {
 		const auto s = _private->getState();
@@ -432,6 +514,21 @@ QString Session::transport() const {
 void Session::sendPrepared(
 		const SerializedRequest &request,
 		crl::time msCanWait) {
+	const auto body = request->constData()
+		+ SerializedRequest::kMessageBodyPosition;
+	const auto length = (request->at(SerializedRequest::kMessageLengthPosition)
+		>> 2);
+	if (_replayer) {
+		const auto requestId = request->requestId;
+		InvokeQueued(this, [=, copy = mtpBuffer(body, body + length)]() mutable {
+			if (_replayer) {
+				_replayer->request(requestId, std::move(copy));
+			}
+		});
+		return;
+	} else if (_recorder) {
+		_recorder->request(request->requestId, body, body + length);
+	}
 	DEBUG_LOG(("MTP Info: adding request to toSendMap, msCanWait %1"
 		).arg(msCanWait));
 	{
@@ -533,6 +630,27 @@ void Session::destroyTemporaryKey(uint64 keyId) {
 	});
 }
 
+std::optional<ConnectionEndpoint> Session::lastGoodEndpoint(
+		DcType type,
+		const ProxyData &proxy) const {
+	return _dc->lastGoodEndpoint(type, proxy);
+}
+
+void Session::registerGoodConnection(
+		DcType type,
+		const ProxyData &proxy,
+		const ConnectionEndpoint &endpoint,
+		crl::time connectDuration) {
+	_dc->setLastGoodEndpoint(type, proxy, endpoint);
+	_dc->registerReconnect(connectDuration);
+
+	DEBUG_LOG(("MTP Info: dcWithShift %1 got first response "
+		"in %2ms after connecting, reconnect stats: %3"
+		).arg(_shiftedDcId
+		).arg(connectDuration
+		).arg(_dc->reconnectStats().toString()));
+}
+
 int32 Session::getDcWithShift() const {
 	return _shiftedDcId;
 }
@@ -566,6 +684,19 @@ void Session::tryToReceive() {
 		if (responses.empty() && updates.empty()) {
 			break;
 		}
+		if (_recorder) {
+			for (const auto &[requestId, response] : responses) {
+				_recorder->response(
+					requestId,
+					response.constData(),
+					response.constData() + response.size());
+			}
+			for (const auto &update : updates) {
+				_recorder->update(
+					update.constData(),
+					update.constData() + update.size());
+			}
+		}
 		for (const auto &[requestId, response] : responses) {
 			_instance->execCallback(
 				requestId,
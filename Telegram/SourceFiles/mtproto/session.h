@@ -25,6 +25,9 @@ namespace details {
 
 class Dcenter;
 class SessionPrivate;
+class TrafficRecorder;
+class TrafficReplayer;
+struct ConnectionEndpoint;
 
 enum class TemporaryKeyType;
 enum class CreatingKeyType;
@@ -49,6 +52,7 @@ struct SessionOptions {
 	bool useIPv6 = true;
 	bool useHttp = true;
 	bool useTcp = true;
+	int bulkConnections = 1;
 
 };
 
@@ -109,6 +113,14 @@ public:
 		const AuthKeyPtr &temporaryKey);
 	void releaseKeyCreationOnFail();
 	void destroyTemporaryKey(uint64 keyId);
+	[[nodiscard]] std::optional<ConnectionEndpoint> lastGoodEndpoint(
+		DcType type,
+		const ProxyData &proxy) const;
+	void registerGoodConnection(
+		DcType type,
+		const ProxyData &proxy,
+		const ConnectionEndpoint &endpoint,
+		crl::time connectDuration);
 
 	void detach();
 
@@ -171,6 +183,14 @@ public:
 	[[nodiscard]] bool releaseCdnKeyCreationOnDone(const AuthKeyPtr &temporaryKey);
 	void releaseKeyCreationOnFail();
 	void destroyTemporaryKey(uint64 keyId);
+	[[nodiscard]] std::optional<ConnectionEndpoint> lastGoodEndpoint(
+		DcType type,
+		const ProxyData &proxy) const;
+	void registerGoodConnection(
+		DcType type,
+		const ProxyData &proxy,
+		const ConnectionEndpoint &endpoint,
+		crl::time connectDuration);
 
 	void notifyDcConnectionInited();
 
@@ -192,6 +212,9 @@ private:
 
 	void killConnection();
 
+	void startTrafficReplay(const QString &folder);
+	void replayReceived(mtpRequestId requestId, mtpBuffer &&data);
+
 	bool rpcErrorOccured(
 		mtpRequestId requestId,
 		const RPCFailHandlerPtr &onFail,
@@ -209,6 +232,10 @@ private:
 
 	SessionPrivate *_private = nullptr;
 
+	// Recorder is used from both threads, replayer only from main.
+	std::unique_ptr<TrafficRecorder> _recorder;
+	std::unique_ptr<TrafficReplayer> _replayer;
+
 	bool _killed = false;
 	bool _needToReceive = false;
 
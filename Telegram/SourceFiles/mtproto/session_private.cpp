@@ -26,6 +26,7 @@ namespace {
 
 constexpr auto kIntSize = static_cast<int>(sizeof(mtpPrime));
 constexpr auto kWaitForBetterTimeout = crl::time(2000);
+constexpr auto kPreferredEndpointPriority = 100;
 constexpr auto kMinConnectedTimeout = crl::time(1000);
 constexpr auto kMaxConnectedTimeout = crl::time(8000);
 constexpr auto kMinReceiveTimeout = crl::time(4000);
@@ -168,9 +169,15 @@ void SessionPrivate::appendTestConnection(
 		const bytes::vector &protocolSecret) {
 	QWriteLocker lock(&_stateMutex);
 
-	const auto priority = (qthelp::is_ipv6(ip) ? 0 : 1)
-		+ (protocol == DcOptions::Variants::Tcp ? 1 : 0)
-		+ (protocolSecret.empty() ? 0 : 1);
+	auto endpoint = ConnectionEndpoint{ protocol, ip, port, protocolSecret };
+
+	// The endpoint that worked last time wins the race right away.
+	const auto priority = (_preferredEndpoint
+		&& *_preferredEndpoint == endpoint)
+		? kPreferredEndpointPriority
+		: ((qthelp::is_ipv6(ip) ? 0 : 1)
+			+ (protocol == DcOptions::Variants::Tcp ? 1 : 0)
+			+ (protocolSecret.empty() ? 0 : 1));
 	_testConnections.push_back({
 		AbstractConnection::Create(
 			_instance,
@@ -178,7 +185,8 @@ void SessionPrivate::appendTestConnection(
 			thread(),
 			protocolSecret,
 			_options->proxy),
-		priority
+		priority,
+		std::move(endpoint)
 	});
 	const auto weak = _testConnections.back().data.get();
 	connect(weak, &AbstractConnection::error, [=](int errorCode) {
@@ -289,6 +297,7 @@ void SessionPrivate::destroyAllConnections() {
 	_waitForReceivedTimer.cancel();
 	_waitForConnectedTimer.cancel();
 	_testConnections.clear();
+	_bulkConnections.clear();
 	_connection = nullptr;
 }
 
@@ -666,16 +675,32 @@ void SessionPrivate::tryToSend() {
 	}
 
 	bool needAnyResponse = false;
+	bool sendMoreStripes = false;
 	SerializedRequest toSendRequest;
 	{
 		QWriteLocker locker1(_sessionData->toSendMutex());
 
 		auto toSendDummy = base::flat_map<mtpRequestId, SerializedRequest>();
-		auto &toSend = sendAll
-			? _sessionData->toSendMap()
-			: toSendDummy;
+		auto toSendStripe = base::flat_map<mtpRequestId, SerializedRequest>();
+		const auto stripes = sendAll ? bulkStripesCount() : 1;
+		auto &toSend = !sendAll
+			? toSendDummy
+			: (stripes > 1)
+			? toSendStripe
+			: _sessionData->toSendMap();
 		if (!sendAll) {
 			locker1.unlock();
+		} else if (stripes > 1) {
+			// Take only a part of the requests, the rest will be sent
+			// in separate packets through other bulk connections.
+			auto &all = _sessionData->toSendMap();
+			const auto take = (all.size() + stripes - 1) / stripes;
+			while (toSendStripe.size() < take) {
+				const auto i = all.begin();
+				toSendStripe.emplace(i->first, std::move(i->second));
+				all.erase(i);
+			}
+			sendMoreStripes = !all.empty();
 		}
 
 		uint32 toSendCount = toSend.size();
@@ -911,7 +936,13 @@ void SessionPrivate::tryToSend() {
 			_sentContainers.emplace(containerMsgId, std::move(sentIdsWrap));
 		}
 	}
-	sendSecureRequest(std::move(toSendRequest), needAnyResponse);
+	const auto primaryOnly = pingRequest
+		|| bindDcKeyRequest
+		|| httpWaitRequest;
+	sendSecureRequest(std::move(toSendRequest), needAnyResponse, primaryOnly);
+	if (sendMoreStripes) {
+		InvokeQueued(this, [=] { tryToSend(); });
+	}
 }
 
 void SessionPrivate::retryByTimer() {
@@ -954,6 +985,9 @@ void SessionPrivate::connectToServer(bool afterConfig) {
 			return;
 		}
 	}
+	_preferredEndpoint = _sessionData->lastGoodEndpoint(
+		_currentDcType,
+		_options->proxy);
 	if (_options->proxy.type == ProxyData::Type::Mtproto) {
 		// host, port, secret for mtproto proxy are taken from proxy.
 		appendTestConnection(DcOptions::Variants::Tcp, {}, 0, {});
@@ -1191,14 +1225,15 @@ void SessionPrivate::requestCDNConfig() {
 	});
 }
 
-void SessionPrivate::handleReceived() {
+void SessionPrivate::handleReceived(
+		not_null<AbstractConnection*> connection) {
 	Expects(_encryptionKey != nullptr);
 
 	onReceivedSome();
 
-	while (!_connection->received().empty()) {
-		auto intsBuffer = std::move(_connection->received().front());
-		_connection->received().pop_front();
+	while (!connection->received().empty()) {
+		auto intsBuffer = std::move(connection->received().front());
+		connection->received().pop_front();
 
 		constexpr auto kExternalHeaderIntsCount = 6U; // 2 auth_key_id, 4 msg_key
 		constexpr auto kEncryptedHeaderIntsCount = 8U; // 2 salt, 2 session, 2 msg_id, 1 seq_no, 1 length
@@ -1350,7 +1385,6 @@ void SessionPrivate::handleReceived() {
 		if (_receivedMessageIds.registerMsgId(msgId, needAck)) {
 			res = handleOneReceived(from, end, msgId, serverTime, serverSalt, badTime);
 		}
-		_receivedMessageIds.shrink();
 
 		// send acks
 		if (const auto toAckSize = _ackRequestData.size()) {
@@ -1378,7 +1412,13 @@ void SessionPrivate::handleReceived() {
 		}
 		_retryTimeout = 1; // reset restart() timer
 
-		_startedConnectingAt = crl::time(0);
+		if (const auto startedAt = base::take(_startedConnectingAt)) {
+			_sessionData->registerGoodConnection(
+				_currentDcType,
+				_options->proxy,
+				_endpoint,
+				crl::now() - startedAt);
+		}
 
 		if (!wasConnected) {
 			if (getState() == ConnectedState) {
@@ -1386,7 +1426,7 @@ void SessionPrivate::handleReceived() {
 			}
 		}
 	}
-	if (_connection->needHttpWait()) {
+	if (connection->needHttpWait()) {
 		_sessionData->queueSendAnything();
 	}
 }
@@ -2244,9 +2284,7 @@ void SessionPrivate::onConnected(
 	} else {
 		DEBUG_LOG(("MTP Info: connection through IPv4 succeed."));
 		_waitForBetterTimer.cancel();
-		_connection = std::move(i->data);
-		_testConnections.clear();
-		checkAuthKey();
+		useTestConnection(std::move(*i));
 	}
 }
 
@@ -2280,7 +2318,12 @@ void SessionPrivate::confirmBestConnection() {
 	DEBUG_LOG(("MTP Info: can't connect through better, using %1."
 		).arg(i->data->tag()));
 
-	_connection = std::move(i->data);
+	useTestConnection(std::move(*i));
+}
+
+void SessionPrivate::useTestConnection(TestConnection &&test) {
+	_connection = std::move(test.data);
+	_endpoint = std::move(test.endpoint);
 	_testConnections.clear();
 
 	checkAuthKey();
@@ -2296,6 +2339,117 @@ void SessionPrivate::removeTestConnection(
 		end(_testConnections));
 }
 
+void SessionPrivate::startBulkConnections() {
+	if (!_bulkConnections.empty()
+		|| _options->bulkConnections < 2
+		|| _endpoint.protocol != DcOptions::Variants::Tcp) {
+		return;
+	}
+	DEBUG_LOG(("MTP Info: starting %1 bulk connections in dc %2."
+		).arg(_options->bulkConnections - 1
+		).arg(_shiftedDcId));
+	for (auto i = 1; i < _options->bulkConnections; ++i) {
+		appendBulkConnection();
+	}
+}
+
+void SessionPrivate::appendBulkConnection() {
+	_bulkConnections.push_back(AbstractConnection::Create(
+		_instance,
+		_endpoint.protocol,
+		thread(),
+		_endpoint.protocolSecret,
+		_options->proxy));
+	const auto weak = _bulkConnections.back().get();
+	connect(weak, &AbstractConnection::error, [=](int errorCode) {
+		DEBUG_LOG(("MTP Info: bulk connection error %1 in dc %2."
+			).arg(errorCode
+			).arg(_shiftedDcId));
+		removeBulkConnection(weak);
+	});
+	connect(weak, &AbstractConnection::disconnected, [=] {
+		removeBulkConnection(weak);
+	});
+	connect(weak, &AbstractConnection::receivedSome, [=] {
+		onReceivedSome();
+	});
+	connect(weak, &AbstractConnection::receivedData, [=] {
+		handleReceived(weak);
+	});
+	connect(weak, &AbstractConnection::connected, [=] {
+		disconnect(weak, &AbstractConnection::connected, nullptr, nullptr);
+		DEBUG_LOG(("MTP Info: bulk connection %1 ready in dc %2."
+			).arg(weak->tag()
+			).arg(_shiftedDcId));
+		_sessionData->queueNeedToResumeAndSend();
+	});
+
+	const auto endpoint = _endpoint;
+	const auto protocolDcId = getProtocolDcId();
+	InvokeQueued(weak, [=] {
+		weak->connectToServer(
+			endpoint.ip,
+			endpoint.port,
+			endpoint.protocolSecret,
+			protocolDcId);
+	});
+}
+
+void SessionPrivate::removeBulkConnection(
+		not_null<AbstractConnection*> connection) {
+	const auto i = ranges::find(
+		_bulkConnections,
+		connection.get(),
+		[](const ConnectionPointer &bulk) { return bulk.get(); });
+	if (i == end(_bulkConnections)) {
+		return;
+	}
+	const auto wasUsed = (*i)->sentEncryptedWithKeyId() != 0;
+	_bulkConnections.erase(i);
+	if (!wasUsed) {
+		return;
+	}
+
+	// Some of the requests could be lost with this connection,
+	// ask the server about all of them instead of waiting for
+	// the checkSentRequests() timeout.
+	{
+		QReadLocker locker(_sessionData->haveSentMutex());
+		for (const auto &[msgId, request] : _sessionData->haveSentMap()) {
+			_stateRequestData.emplace(msgId);
+		}
+	}
+	if (!_stateRequestData.empty()) {
+		_sessionData->queueSendAnything(kSendStateRequestWaiting);
+	}
+}
+
+int SessionPrivate::bulkStripesCount() const {
+	return 1 + int(ranges::count_if(
+		_bulkConnections,
+		[](const ConnectionPointer &bulk) { return bulk->isConnected(); }));
+}
+
+not_null<AbstractConnection*> SessionPrivate::chooseSendConnection(
+		bool primaryOnly) {
+	Expects(_connection != nullptr);
+
+	if (primaryOnly || _bulkConnections.empty()) {
+		return _connection.get();
+	}
+	const auto count = int(_bulkConnections.size()) + 1;
+	for (auto i = 0; i != count; ++i) {
+		_bulkSendIndex = (_bulkSendIndex + 1) % count;
+		const auto connection = _bulkSendIndex
+			? _bulkConnections[_bulkSendIndex - 1].get()
+			: _connection.get();
+		if (connection->isConnected()) {
+			return connection;
+		}
+	}
+	return _connection.get();
+}
+
 void SessionPrivate::checkAuthKey() {
 	if (_keyId) {
 		authKeyChecked();
@@ -2495,9 +2649,11 @@ DcType SessionPrivate::tryAcquireKeyCreation() {
 }
 
 void SessionPrivate::authKeyChecked() {
-	connect(_connection, &AbstractConnection::receivedData, [=] {
-		handleReceived();
+	const auto connection = _connection.get();
+	connect(connection, &AbstractConnection::receivedData, [=] {
+		handleReceived(connection);
 	});
+	startBulkConnections();
 
 	if (_sessionSalt && setState(ConnectedState)) {
 		resendAll();
@@ -2556,13 +2712,15 @@ void SessionPrivate::destroyTemporaryKey() {
 
 bool SessionPrivate::sendSecureRequest(
 		SerializedRequest &&request,
-		bool needAnyResponse) {
+		bool needAnyResponse,
+		bool primaryOnly) {
 #ifdef TDESKTOP_MTPROTO_OLD
 	const auto oldPadding = true;
 #else // TDESKTOP_MTPROTO_OLD
 	const auto oldPadding = false;
 #endif // TDESKTOP_MTPROTO_OLD
-	request.addPadding(_connection->requiresExtendedPadding(), oldPadding);
+	const auto connection = chooseSendConnection(primaryOnly);
+	request.addPadding(connection->requiresExtendedPadding(), oldPadding);
 
 	uint32 fullSize = request->size();
 	if (fullSize < 9) {
@@ -2594,7 +2752,7 @@ bool SessionPrivate::sendSecureRequest(
 		(fullSize - padding) * sizeof(mtpPrime),
 		encryptedSHA);
 
-	auto packet = _connection->prepareSecurePacket(_keyId, msgKey, fullSize);
+	auto packet = connection->prepareSecurePacket(_keyId, msgKey, fullSize);
 	const auto prefix = packet.size();
 	packet.resize(prefix + fullSize);
 
@@ -2614,7 +2772,7 @@ bool SessionPrivate::sendSecureRequest(
 	SHA256_Update(&msgKeyLargeContext, request->constData(), fullSize * sizeof(mtpPrime));
 	SHA256_Final(encryptedSHA256, &msgKeyLargeContext);
 
-	auto packet = _connection->prepareSecurePacket(_keyId, msgKey, fullSize);
+	auto packet = connection->prepareSecurePacket(_keyId, msgKey, fullSize);
 	const auto prefix = packet.size();
 	packet.resize(prefix + fullSize);
 
@@ -2628,8 +2786,8 @@ bool SessionPrivate::sendSecureRequest(
 
 	DEBUG_LOG(("MTP Info: sending request, size: %1, num: %2, time: %3").arg(fullSize + 6).arg((*request)[4]).arg((*request)[5]));
 
-	_connection->setSentEncryptedWithKeyId(_keyId);
-	_connection->sendData(std::move(packet));
+	connection->setSentEncryptedWithKeyId(_keyId);
+	connection->sendData(std::move(packet));
 
 	if (needAnyResponse) {
 		onSentSome((prefix + fullSize) * sizeof(mtpPrime));
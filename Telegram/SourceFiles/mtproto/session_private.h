@@ -7,6 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #pragma once
 
+#include "mtproto/details/mtproto_dcenter.h"
 #include "mtproto/details/mtproto_received_ids_manager.h"
 #include "mtproto/details/mtproto_serialized_request.h"
 #include "mtproto/mtproto_auth_key.h"
@@ -57,6 +58,7 @@ private:
 	struct TestConnection {
 		ConnectionPointer data;
 		int priority = 0;
+		ConnectionEndpoint endpoint;
 	};
 	struct SentContainer {
 		crl::time sent = 0;
@@ -85,7 +87,7 @@ private:
 	void onSentSome(uint64 size);
 	void onReceivedSome();
 
-	void handleReceived();
+	void handleReceived(not_null<AbstractConnection*> connection);
 
 	void retryByTimer();
 	void waitConnectedFailed();
@@ -96,7 +98,15 @@ private:
 	void destroyAllConnections();
 
 	void confirmBestConnection();
+	void useTestConnection(TestConnection &&test);
 	void removeTestConnection(not_null<AbstractConnection*> connection);
+
+	void startBulkConnections();
+	void appendBulkConnection();
+	void removeBulkConnection(not_null<AbstractConnection*> connection);
+	[[nodiscard]] int bulkStripesCount() const;
+	[[nodiscard]] not_null<AbstractConnection*> chooseSendConnection(
+		bool primaryOnly);
 	[[nodiscard]] int16 getProtocolDcId() const;
 
 	void checkSentRequests();
@@ -117,7 +127,8 @@ private:
 
 	bool sendSecureRequest(
 		SerializedRequest &&request,
-		bool needAnyResponse);
+		bool needAnyResponse,
+		bool primaryOnly = true);
 	mtpRequestId wasSent(mtpMsgId msgId) const;
 
 	[[nodiscard]] HandleResult handleOneReceived(const mtpPrime *from, const mtpPrime *end, uint64 msgId, int32 serverTime, uint64 serverSalt, bool badTime);
@@ -185,7 +196,11 @@ private:
 	bool _needSessionReset = false;
 
 	ConnectionPointer _connection;
+	ConnectionEndpoint _endpoint;
+	std::optional<ConnectionEndpoint> _preferredEndpoint;
 	std::vector<TestConnection> _testConnections;
+	std::vector<ConnectionPointer> _bulkConnections;
+	int _bulkSendIndex = 0;
 	crl::time _startedConnectingAt = 0;
 
 	base::Timer _retryTimer; // exp retry timer
@@ -30,6 +30,8 @@ QString gWorkingDir, gExeDir, gExeName;
 
 QStringList gSendPaths;
 QString gStartUrl;
+QString gMtpRecordPath, gMtpReplayPath;
+QString gExportRunPath;
 
 QString gDialogLastPath, gDialogHelperPath; // optimize QFileDialog
 
@@ -128,6 +128,9 @@ DeclareSetting(crl::time, PasscodeLastTry);
 
 DeclareSetting(QStringList, SendPaths);
 DeclareSetting(QString, StartUrl);
+DeclareSetting(QString, MtpRecordPath);
+DeclareSetting(QString, MtpReplayPath);
+DeclareSetting(QString, ExportRunPath);
 
 DeclareSetting(int, OtherOnline);
 
@@ -45,6 +45,8 @@ constexpr auto kStickersSerializeVersion = 1;
 constexpr auto kMaxSavedStickerSetsCount = 1000;
 constexpr auto kDefaultStickerInstallDate = TimeId(1);
 
+constexpr auto kMessagesCacheSizeLimit = 32 * 1024 * 1024;
+
 constexpr auto kSinglePeerTypeUser = qint32(1);
 constexpr auto kSinglePeerTypeChat = qint32(2);
 constexpr auto kSinglePeerTypeChannel = qint32(3);
@@ -1296,6 +1298,20 @@ Cache::Database::Settings Account::cacheBigFileSettings() const {
 	return result;
 }
 
+QString Account::messagesCachePath() const {
+	Expects(!_databasePath.isEmpty());
+
+	return _databasePath + "history_cache";
+}
+
+Cache::Database::Settings Account::messagesCacheSettings() const {
+	auto result = Cache::Database::Settings();
+	result.clearOnWrongKey = true;
+	result.totalSizeLimit = kMessagesCacheSizeLimit;
+	result.totalTimeLimit = 0;
+	return result;
+}
+
 void Account::writeStickerSet(
 		QDataStream &stream,
 		const Data::StickersSet &set) {
@@ -101,6 +101,9 @@ public:
 	[[nodiscard]] QString cacheBigFilePath() const;
 	[[nodiscard]] Cache::Database::Settings cacheBigFileSettings() const;
 
+	[[nodiscard]] QString messagesCachePath() const;
+	[[nodiscard]] Cache::Database::Settings messagesCacheSettings() const;
+
 	void writeInstalledStickers();
 	void writeFeaturedStickers();
 	void writeRecentStickers();
@@ -0,0 +1,160 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/storage_messages_cache.h"
+
+#include "storage/storage_account.h"
+#include "storage/cache/storage_cache_database.h"
+#include "main/main_session.h"
+#include "data/data_session.h"
+#include "history/history.h"
+#include "core/application.h"
+
+namespace Storage {
+namespace {
+
+constexpr auto kSliceKeyTag = 0x0000000000000002ULL;
+constexpr auto kSerializeVersion = mtpPrime(1);
+
+[[nodiscard]] Cache::Key DatabaseKey(not_null<History*> history) {
+	return Cache::Key{ kSliceKeyTag, uint64(history->peer->id) };
+}
+
+[[nodiscard]] PeerId UserPeerId(const MTPUser &user) {
+	return user.match([](const auto &data) {
+		return peerFromUser(data.vid());
+	});
+}
+
+[[nodiscard]] PeerId ChatPeerId(const MTPChat &chat) {
+	return chat.match([](const MTPDchannel &data) {
+		return peerFromChannel(data.vid());
+	}, [](const MTPDchannelForbidden &data) {
+		return peerFromChannel(data.vid());
+	}, [](const auto &data) {
+		return peerFromChat(data.vid());
+	});
+}
+
+} // namespace
+
+MessagesCache::MessagesCache(not_null<Main::Session*> session)
+: _session(session)
+, _database(Core::App().databases().get(
+	session->local().messagesCachePath(),
+	session->local().messagesCacheSettings())) {
+	_database->open(session->local().cacheKey());
+}
+
+MessagesCache::~MessagesCache() = default;
+
+void MessagesCache::put(
+		not_null<History*> history,
+		const MTPmessages_Messages &slice) {
+	auto serialized = Serialize(slice);
+	if (serialized.isEmpty()) {
+		remove(history);
+	} else {
+		_database->put(DatabaseKey(history), std::move(serialized));
+	}
+}
+
+void MessagesCache::get(
+		not_null<History*> history,
+		Fn<void(const MTPmessages_Messages&)> done) {
+	// Parse TL right in the database thread, it is plain data.
+	_database->get(DatabaseKey(history), [=](QByteArray &&stored) {
+		auto slice = Deserialize(stored);
+		if (!slice) {
+			return;
+		}
+		crl::on_main(this, [=, slice = std::move(*slice)] {
+			done(skipLoadedPeers(slice.c_messages_messages()));
+		});
+	});
+}
+
+void MessagesCache::remove(not_null<History*> history) {
+	_database->remove(DatabaseKey(history));
+}
+
+void MessagesCache::clear() {
+	_database->close();
+	_database->clear();
+}
+
+MTPmessages_Messages MessagesCache::skipLoadedPeers(
+		const MTPDmessages_messages &data) const {
+	const auto &owner = _session->data();
+	auto users = QVector<MTPUser>();
+	users.reserve(data.vusers().v.size());
+	for (const auto &user : data.vusers().v) {
+		if (!owner.peerLoaded(UserPeerId(user))) {
+			users.push_back(user);
+		}
+	}
+	auto chats = QVector<MTPChat>();
+	chats.reserve(data.vchats().v.size());
+	for (const auto &chat : data.vchats().v) {
+		if (!owner.peerLoaded(ChatPeerId(chat))) {
+			chats.push_back(chat);
+		}
+	}
+	return MTP_messages_messages(
+		data.vmessages(),
+		MTP_vector<MTPChat>(std::move(chats)),
+		MTP_vector<MTPUser>(std::move(users)));
+}
+
+QByteArray MessagesCache::Serialize(const MTPmessages_Messages &slice) {
+	// Keep only the data we show, whatever the response type was,
+	// pts of a channel from the cache would be outdated anyway.
+	const auto messages = slice.match([](
+			const MTPDmessages_messagesNotModified &) {
+		return std::optional<MTPmessages_Messages>();
+	}, [](const auto &data) {
+		return data.vmessages().v.isEmpty()
+			? std::optional<MTPmessages_Messages>()
+			: std::make_optional(MTP_messages_messages(
+				data.vmessages(),
+				data.vchats(),
+				data.vusers()));
+	});
+	if (!messages) {
+		return QByteArray();
+	}
+	auto buffer = mtpBuffer();
+	buffer.reserve(1 + (tl::count_length(*messages) >> 2));
+	buffer.push_back(kSerializeVersion);
+	messages->write(buffer);
+	return QByteArray(
+		reinterpret_cast<const char*>(buffer.data()),
+		buffer.size() * sizeof(mtpPrime));
+}
+
+auto MessagesCache::Deserialize(const QByteArray &data)
+-> std::optional<MTPmessages_Messages> {
+	if (data.isEmpty() || (data.size() % sizeof(mtpPrime))) {
+		return std::nullopt;
+	}
+	auto buffer = mtpBuffer(data.size() / sizeof(mtpPrime));
+	bytes::copy(bytes::make_span(buffer), bytes::make_span(data));
+	auto from = buffer.constData();
+	const auto end = from + buffer.size();
+	if (*from++ != kSerializeVersion) {
+		return std::nullopt;
+	}
+	auto result = MTPmessages_Messages();
+	if (!result.read(from, end)
+		|| from != end
+		|| result.type() != mtpc_messages_messages) {
+		return std::nullopt;
+	}
+	return result;
+}
+
+} // namespace Storage
@@ -0,0 +1,58 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "storage/storage_databases.h"
+#include "base/weak_ptr.h"
+
+class History;
+
+namespace Main {
+class Session;
+} // namespace Main
+
+namespace Storage {
+
+// Last messages slice of each history, kept in an encrypted size limited
+// Cache::Database in the account folder as serialized messages.messages.
+//
+// It is shown while the first page is requested from the server, so that
+// opening a chat doesn't wait for the network, and replaced by the server
+// slice when that one arrives.
+class MessagesCache final : public base::has_weak_ptr {
+public:
+	explicit MessagesCache(not_null<Main::Session*> session);
+	~MessagesCache();
+
+	void put(not_null<History*> history, const MTPmessages_Messages &slice);
+
+	// The callback is called on the main thread only if a slice was found,
+	// always with a messages.messages. Users and chats that are already
+	// loaded are skipped, they're more recent than the cached ones.
+	void get(
+		not_null<History*> history,
+		Fn<void(const MTPmessages_Messages&)> done);
+
+	void remove(not_null<History*> history);
+	void clear();
+
+private:
+	[[nodiscard]] static QByteArray Serialize(
+		const MTPmessages_Messages &slice);
+	[[nodiscard]] static std::optional<MTPmessages_Messages> Deserialize(
+		const QByteArray &data);
+
+	[[nodiscard]] MTPmessages_Messages skipLoadedPeers(
+		const MTPDmessages_messages &data) const;
+
+	const not_null<Main::Session*> _session;
+	DatabasePointer _database;
+
+};
+
+} // namespace Storage
@@ -0,0 +1,207 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/storage_messages_index.h"
+
+#include "main/main_session.h"
+#include "main/main_session_settings.h"
+#include "data/data_session.h"
+#include "history/history.h"
+#include "history/history_item.h"
+#include "ui/text/text_utilities.h"
+
+namespace Storage {
+namespace {
+
+constexpr auto kMinPrefixLength = 2;
+constexpr auto kMaxPrefixLength = 8;
+constexpr auto kMaxEntriesPerPrefix = 4096;
+constexpr auto kMaxEntriesCount = 512 * 1024;
+constexpr auto kMaxSearchResults = 100;
+
+[[nodiscard]] uint64 PrefixKey(const QString &word, int length) {
+	// Different prefixes may share the key, search() checks the text.
+	return (uint64(length) << 32) | uint64(qHash(word.midRef(0, length)));
+}
+
+[[nodiscard]] bool HasAllWords(
+		not_null<HistoryItem*> item,
+		const QStringList &words) {
+	const auto itemWords = TextUtilities::PrepareSearchWords(
+		item->originalText().text);
+	const auto found = [&](const QString &word) {
+		for (const auto &itemWord : itemWords) {
+			if (itemWord.startsWith(word)) {
+				return true;
+			}
+		}
+		return false;
+	};
+	for (const auto &word : words) {
+		if (!found(word)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+MessagesIndex::MessagesIndex(not_null<Main::Session*> session)
+: _session(session) {
+}
+
+MessagesIndex::~MessagesIndex() = default;
+
+bool MessagesIndex::enabled() const {
+	return _session->settings().localSearchIndex();
+}
+
+void MessagesIndex::add(not_null<HistoryItem*> item) {
+	if (!enabled()
+		|| !IsServerMsgId(item->id)
+		|| !item->isHistoryEntry()
+		|| item->serviceMsg()) {
+		return;
+	}
+	addWords(
+		item->originalText().text,
+		{ item->history()->peer->id, item->id });
+}
+
+void MessagesIndex::add(const std::vector<not_null<HistoryItem*>> &items) {
+	for (const auto item : items) {
+		add(item);
+	}
+}
+
+void MessagesIndex::addWords(const QString &text, Entry entry) {
+	if (text.isEmpty()) {
+		return;
+	}
+	auto keys = base::flat_set<uint64>();
+	for (const auto &word : TextUtilities::PrepareSearchWords(text)) {
+		const auto till = std::min(int(word.size()), kMaxPrefixLength);
+		for (auto length = kMinPrefixLength; length <= till; ++length) {
+			keys.emplace(PrefixKey(word, length));
+		}
+	}
+	for (const auto key : keys) {
+		// Drop the earliest added entries in bulk when the list is full.
+		auto &entries = _prefixes[key];
+		if (int(entries.size()) >= kMaxEntriesPerPrefix) {
+			entries.erase(
+				begin(entries),
+				begin(entries) + kMaxEntriesPerPrefix / 4);
+			_entriesCount -= kMaxEntriesPerPrefix / 4;
+		}
+		entries.push_back(entry);
+		++_entriesCount;
+	}
+	if (_entriesCount > kMaxEntriesCount) {
+		trim();
+	}
+}
+
+void MessagesIndex::trim() {
+	// Drop the earliest added quarter of each list, it happens rarely.
+	_entriesCount = 0;
+	for (auto i = begin(_prefixes); i != end(_prefixes);) {
+		auto &entries = i->second;
+		entries.erase(
+			begin(entries),
+			begin(entries) + (entries.size() + 3) / 4);
+		if (entries.empty()) {
+			i = _prefixes.erase(i);
+		} else {
+			_entriesCount += int(entries.size());
+			++i;
+		}
+	}
+}
+
+std::vector<not_null<HistoryItem*>> MessagesIndex::search(
+		const QString &query,
+		PeerId peerId) const {
+	const auto words = TextUtilities::PrepareSearchWords(query);
+	if (!enabled() || words.isEmpty()) {
+		return {};
+	}
+
+	// Intersect the lists of all the query words, shortest first.
+	auto lists = std::vector<const Entries*>();
+	for (const auto &word : words) {
+		if (word.size() < kMinPrefixLength) {
+			continue;
+		}
+		const auto i = _prefixes.find(PrefixKey(
+			word,
+			std::min(int(word.size()), kMaxPrefixLength)));
+		if (i == end(_prefixes)) {
+			return {};
+		}
+		lists.push_back(&i->second);
+	}
+	if (lists.empty()) {
+		return {};
+	}
+	ranges::sort(lists, ranges::less(), [](const Entries *list) {
+		return list->size();
+	});
+	auto candidates = base::flat_set<Entry>();
+	for (const auto &entry : *lists.front()) {
+		if (!peerId || entry.peerId == peerId) {
+			candidates.emplace(entry);
+		}
+	}
+	for (auto i = begin(lists) + 1; i != end(lists); ++i) {
+		auto left = base::flat_set<Entry>();
+		for (const auto &entry : **i) {
+			if (candidates.contains(entry)) {
+				left.emplace(entry);
+			}
+		}
+		candidates = std::move(left);
+	}
+
+	auto items = std::vector<not_null<HistoryItem*>>();
+	const auto &owner = _session->data();
+	for (const auto &entry : candidates) {
+		const auto item = owner.message(
+			peerToChannel(entry.peerId),
+			entry.msgId);
+		if (item && item->history()->peer->id == entry.peerId) {
+			items.push_back(item);
+		}
+	}
+	ranges::sort(items, [](
+			not_null<HistoryItem*> a,
+			not_null<HistoryItem*> b) {
+		return (a->date() > b->date())
+			|| (a->date() == b->date() && a->id > b->id);
+	});
+
+	// The keys cover only the first kMaxPrefixLength letters and may
+	// collide, so check the text itself, newest first, until we have enough.
+	auto result = std::vector<not_null<HistoryItem*>>();
+	for (const auto item : items) {
+		if (HasAllWords(item, words)) {
+			result.push_back(item);
+			if (int(result.size()) == kMaxSearchResults) {
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+void MessagesIndex::clear() {
+	_prefixes.clear();
+	_entriesCount = 0;
+}
+
+} // namespace Storage
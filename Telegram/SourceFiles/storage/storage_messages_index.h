@@ -0,0 +1,67 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include <unordered_map>
+
+class HistoryItem;
+
+namespace Main {
+class Session;
+} // namespace Main
+
+namespace Storage {
+
+// Local full-text index of the messages we've received in this session.
+//
+// For each word prefix it keeps the list of message ids containing a word
+// with that prefix, and the lists together are limited in size.
+//
+// The index lives in memory and isn't saved anywhere. search() can return
+// only the messages that are loaded, a saved index would point mostly to
+// messages that are not loaded after a restart, and they'd have to be
+// requested from the server anyway, like with the usual server search.
+class MessagesIndex final {
+public:
+	explicit MessagesIndex(not_null<Main::Session*> session);
+	~MessagesIndex();
+
+	void add(not_null<HistoryItem*> item);
+	void add(const std::vector<not_null<HistoryItem*>> &items);
+
+	// Loaded messages matching all query words, newest first.
+	// If peerId is not zero only messages from that chat are returned.
+	[[nodiscard]] std::vector<not_null<HistoryItem*>> search(
+		const QString &query,
+		PeerId peerId) const;
+
+	void clear();
+
+private:
+	struct Entry {
+		PeerId peerId = 0;
+		MsgId msgId = 0;
+
+		inline bool operator<(const Entry &other) const {
+			return std::tie(peerId, msgId)
+				< std::tie(other.peerId, other.msgId);
+		}
+	};
+	using Entries = std::vector<Entry>;
+
+	[[nodiscard]] bool enabled() const;
+	void addWords(const QString &text, Entry entry);
+	void trim();
+
+	const not_null<Main::Session*> _session;
+	std::unordered_map<uint64, Entries> _prefixes;
+	int _entriesCount = 0;
+
+};
+
+} // namespace Storage
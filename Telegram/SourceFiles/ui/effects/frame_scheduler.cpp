@@ -0,0 +1,128 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "ui/effects/frame_scheduler.h"
+
+namespace Ui {
+namespace {
+
+constexpr auto kFrameBudget = 1000. / 60.;
+constexpr auto kOverloadThreshold = 1.25;
+constexpr auto kMaxTickInterval = 8;
+constexpr auto kMaxTickDuration = crl::time(200);
+constexpr auto kStopAfterIdleTicks = 4;
+
+} // namespace
+
+FrameScheduler::FrameScheduler()
+: _animation([=](crl::time now) { tick(now); }) {
+}
+
+Fn<void()> FrameScheduler::wrap(
+		FramePriority priority,
+		Fn<void()> repaint,
+		rpl::lifetime &lifetime) {
+	const auto id = ++_autoincrement;
+	_clients.emplace(id, Client{ priority, std::move(repaint) });
+
+	const auto weak = base::make_weak(this);
+	lifetime.add([=] {
+		if (const auto strong = weak.get()) {
+			strong->_clients.remove(id);
+		}
+	});
+	return [=] {
+		if (const auto strong = weak.get()) {
+			strong->request(id);
+		}
+	};
+}
+
+int FrameScheduler::droppedFrames(FramePriority priority) const {
+	return _dropped[int(priority)];
+}
+
+void FrameScheduler::request(uint64 id) {
+	const auto i = _clients.find(id);
+	if (i == end(_clients)) {
+		return;
+	}
+	i->second.requested = true;
+	_idleTicks = 0;
+	if (!_animation.animating()) {
+		_animation.start();
+	}
+}
+
+void FrameScheduler::updateLoad(crl::time now) {
+	if (_lastTick) {
+		// A long pause means the app was idle or hidden, not overloaded.
+		const auto duration = std::min(now - _lastTick, kMaxTickDuration);
+		_tickDuration = (_tickDuration * 7. + duration) / 8.;
+	}
+	_lastTick = now;
+}
+
+int FrameScheduler::tickInterval(FramePriority priority) const {
+	const auto overload = _tickDuration / kFrameBudget;
+	if (overload < kOverloadThreshold) {
+		return 1;
+	}
+	const auto result = [&] {
+		switch (priority) {
+		case FramePriority::Chat:
+			return (overload < 3.) ? 1 : int(overload / 2.);
+		case FramePriority::Panel: return int(std::round(overload));
+		case FramePriority::Background:
+			return int(std::round(overload * 2.));
+		}
+		Unexpected("Priority in FrameScheduler::tickInterval.");
+	}();
+	return std::clamp(result, 1, kMaxTickInterval);
+}
+
+void FrameScheduler::tick(crl::time now) {
+	updateLoad(now);
+	++_ticks;
+
+	auto requested = false;
+	for (auto &[id, client] : _clients) {
+		if (!client.requested) {
+			continue;
+		}
+		requested = true;
+		if (_ticks % tickInterval(client.priority)) {
+			++_dropped[int(client.priority)];
+			continue;
+		}
+		client.requested = false;
+		_delivering.push_back(client.repaint);
+	}
+
+	// Keep ticking for a while, so that the load is measured between
+	// the frames of the animations that play slower than the ticks.
+	if (!requested && ++_idleTicks >= kStopAfterIdleTicks) {
+		DEBUG_LOG(("Animations: Frames dropped %1 chat, %2 panel, "
+			"%3 background."
+			).arg(droppedFrames(FramePriority::Chat)
+			).arg(droppedFrames(FramePriority::Panel)
+			).arg(droppedFrames(FramePriority::Background)));
+		_animation.stop();
+		_lastTick = 0;
+		_tickDuration = 0.;
+	}
+
+	// Repaint callbacks may add or remove clients.
+	auto delivering = base::take(_delivering);
+	for (const auto &repaint : delivering) {
+		repaint();
+	}
+	delivering.clear();
+	_delivering = std::move(delivering);
+}
+
+} // namespace Ui
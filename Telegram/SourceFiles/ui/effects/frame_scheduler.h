@@ -0,0 +1,70 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "ui/effects/animations.h"
+#include "base/weak_ptr.h"
+
+namespace Ui {
+
+enum class FramePriority : uchar {
+	Background,
+	Panel,
+	Chat,
+};
+
+inline constexpr auto kFramePrioritiesCount = 3;
+
+// Collects the repaint requests of the playing stickers and GIFs and
+// delivers them together once per animation tick.
+//
+// When the ticks start coming late, because the main thread can't keep
+// up with painting everything, the requests of lower priority are held
+// back for a few ticks, so that their animations play with a lower frame
+// rate while the chat keeps playing smoothly.
+class FrameScheduler final : public base::has_weak_ptr {
+public:
+	FrameScheduler();
+	FrameScheduler(const FrameScheduler &other) = delete;
+	FrameScheduler &operator=(const FrameScheduler &other) = delete;
+
+	// The returned callback may be called any number of times between
+	// the ticks, the repaint is called once on the tick it's delivered.
+	[[nodiscard]] Fn<void()> wrap(
+		FramePriority priority,
+		Fn<void()> repaint,
+		rpl::lifetime &lifetime);
+
+	// Ticks on which a requested repaint was held back.
+	[[nodiscard]] int droppedFrames(FramePriority priority) const;
+
+private:
+	struct Client {
+		FramePriority priority = FramePriority::Chat;
+		Fn<void()> repaint;
+		bool requested = false;
+	};
+
+	void request(uint64 id);
+	void tick(crl::time now);
+	void updateLoad(crl::time now);
+	[[nodiscard]] int tickInterval(FramePriority priority) const;
+
+	base::flat_map<uint64, Client> _clients;
+	uint64 _autoincrement = 0;
+	Animations::Basic _animation;
+	crl::time _lastTick = 0;
+	float64 _tickDuration = 0.;
+	int _ticks = 0;
+	int _idleTicks = 0;
+	std::vector<Fn<void()>> _delivering;
+	std::array<int, kFramePrioritiesCount> _dropped = { { 0 } };
+
+};
+
+} // namespace Ui
@@ -15,9 +15,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/stickers/data_stickers.h"
 #include "ui/image/image.h"
 #include "ui/emoji_config.h"
+#include "ui/effects/frame_scheduler.h"
 #include "lottie/lottie_single_player.h"
 #include "main/main_session.h"
 #include "window/window_session_controller.h"
+#include "core/application.h"
 #include "styles/style_layers.h"
 #include "styles/style_chat_helpers.h"
 #include "styles/style_history.h"
@@ -36,6 +38,10 @@ MediaPreviewWidget::MediaPreviewWidget(
 , _controller(controller)
 , _emojiSize(Ui::Emoji::GetSizeLarge() / cIntRetinaFactor()) {
 	setAttribute(Qt::WA_TransparentForMouseEvents);
+	_repaintFrame = Core::App().frameScheduler().wrap(
+		Ui::FramePriority::Panel,
+		[=] { update(updateArea()); },
+		lifetime());
 	_controller->session().downloaderTaskFinished(
 	) | rpl::start_with_next([=] {
 		update();
@@ -251,7 +257,7 @@ void MediaPreviewWidget::setupLottie() {
 		v::match(update.data, [&](const Lottie::Information &) {
 			this->update();
 		}, [&](const Lottie::DisplayFrameRequest &) {
-			this->update(updateArea());
+			_repaintFrame();
 		});
 	}, lifetime());
 }
@@ -416,7 +422,7 @@ void MediaPreviewWidget::clipCallback(
 			|| (_gifThumbnail
 				&& _gifThumbnail->started()
 				&& !_gifThumbnail->currentDisplayed())) {
-			update(updateArea());
+			_repaintFrame();
 		}
 	} break;
 	}
@@ -68,6 +68,7 @@ private:
 	Media::Clip::ReaderPointer _gif, _gifThumbnail;
 	crl::time _gifLastPosition = 0;
 	std::unique_ptr<Lottie::SinglePlayer> _lottie;
+	Fn<void()> _repaintFrame;
 
 	int _emojiSize;
 	std::vector<not_null<EmojiPtr>> _emojiList;
@@ -22,6 +22,8 @@ PRIVATE
     export/data/export_data_types.h
     export/output/export_output_abstract.cpp
     export/output/export_output_abstract.h
+    export/output/export_output_checkpoint.cpp
+    export/output/export_output_checkpoint.h
     export/output/export_output_file.cpp
     export/output/export_output_file.h
     export/output/export_output_html.cpp